@@ -0,0 +1,60 @@
+#ifndef CONSTEXPR_MATH_H
+#define CONSTEXPR_MATH_H
+
+// Minimal compile-time replacements for <cmath> functions, accurate to
+// roughly double precision over the ranges used for table generation.
+namespace constexpr_math {
+
+constexpr double ln2 = 0.693147180559945309417232121458176568;
+
+// Natural logarithm of a positive, finite value
+constexpr double log(double x) {
+    // Reduce to x = m * 2^e with m in [1, 2)
+    int exponent = 0;
+    while (x >= 2.0) {
+        x /= 2.0;
+        exponent++;
+    }
+    while (x < 1.0) {
+        x *= 2.0;
+        exponent--;
+    }
+
+    // log(m) = 2 atanh((m - 1) / (m + 1)), with |z| <= 1/3
+    const double z = (x - 1.0) / (x + 1.0);
+    const double z2 = z * z;
+    double term = z;
+    double sum = 0.0;
+    for (int k = 1; k < 40; k += 2) {
+        sum += term / k;
+        term *= z2;
+    }
+    return 2.0 * sum + exponent * ln2;
+}
+
+constexpr double exp(double x) {
+    // Reduce to x = k ln(2) + r with |r| <= ln(2) / 2
+    const int k = (int)(x / ln2 + (x < 0 ? -0.5 : 0.5));
+    const double r = x - k * ln2;
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= r / n;
+        sum += term;
+    }
+
+    for (int n = 0; n < k; n++) sum *= 2.0;
+    for (int n = 0; n > k; n--) sum /= 2.0;
+    return sum;
+}
+
+constexpr double log2(double x) { return log(x) / ln2; }
+constexpr double exp2(double x) { return exp(x * ln2); }
+constexpr double pow(double base, double exponent) {
+    return exp(exponent * log(base));
+}
+
+}  // namespace constexpr_math
+
+#endif /* CONSTEXPR_MATH_H */
@@ -0,0 +1,34 @@
+#include "fixed_stft.h"
+
+#include "note_stft.h"
+
+// The note_stft configuration (16384-sample window, 4x zero padding, 401
+// notes over [-50, 50]) at the common sample rates
+template <unsigned long SampleRate>
+using NoteSTFT =
+    FixedSTFT<note_stft::window_length, note_stft::transform_length,
+              SampleRate, note_stft::num_notes, note_stft::min_note,
+              note_stft::max_note>;
+typedef NoteSTFT<44100> STFT_16384_44100;
+typedef NoteSTFT<48000> STFT_16384_48000;
+
+template <typename T>
+static bool matches(const SpectrogramInput &props,
+                    const SpectrogramConfig &config, int num_notes,
+                    int min_note, int max_note) {
+    return props.sample_rate == T::sample_rate &&
+           config.window_length == T::window_length &&
+           config.transform_length == T::transform_length &&
+           num_notes == T::num_notes && min_note == T::min_note &&
+           max_note == T::max_note;
+}
+
+SpectrumMap find_fixed_stft(const SpectrogramInput &props,
+                            const SpectrogramConfig &config, int num_notes,
+                            int min_note, int max_note) {
+    if (matches<STFT_16384_44100>(props, config, num_notes, min_note, max_note))
+        return STFT_16384_44100::map;
+    if (matches<STFT_16384_48000>(props, config, num_notes, min_note, max_note))
+        return STFT_16384_48000::map;
+    return nullptr;
+}
@@ -0,0 +1,95 @@
+#ifndef FIXED_STFT_H
+#define FIXED_STFT_H
+
+#include <spectrogram.h>
+
+#include "constexpr_math.h"
+#include "kernels.h"
+
+// Maps a raw power spectrum onto the note grid: notes = resample(scale(raw))
+typedef void (*SpectrumMap)(float *raw_power, float *notes);
+
+// Lookup tables for one analysis configuration, generated at compile time
+template <unsigned long TransformLength, unsigned long SampleRate, int NumNotes,
+          int MinNote, int MaxNote>
+struct FixedSTFTTables {
+    static constexpr unsigned long num_raw = TransformLength / 2 + 1;
+
+    // Frequency-dependent scaling of the raw spectrum
+    alignas(64) float weights[num_raw];
+
+    // Linear interpolation from raw bins onto notes
+    alignas(64) unsigned int idxlow[NumNotes];
+    alignas(64) unsigned int idxhigh[NumNotes];
+    alignas(64) float scale[NumNotes];
+
+    // Range of raw bins that contribute to any note
+    unsigned int first_bin;
+    unsigned int last_bin;
+
+    constexpr FixedSTFTTables()
+        : weights{}, idxlow{}, idxhigh{}, scale{}, first_bin(0), last_bin(0) {
+        const double bin_width = (double)SampleRate / TransformLength;
+        const double step = (MaxNote - MinNote) / (NumNotes - 1.0);
+        for (int idx = 0; idx < NumNotes; idx++) {
+            const double note = MinNote + idx * step;
+            const double freq = 440.0 * constexpr_math::exp2(note / 12.0);
+            const unsigned int low = (unsigned int)(freq / bin_width);
+            idxlow[idx] = low;
+            idxhigh[idx] = low + 1;
+            scale[idx] = (float)((freq - low * bin_width) / bin_width);
+        }
+        first_bin = idxlow[0];
+        last_bin = idxhigh[NumNotes - 1];
+
+        // Bins outside [first_bin, last_bin] are never read, so leave them 0
+        for (unsigned int idx = first_bin; idx <= last_bin; idx++) {
+            const double log_freq = constexpr_math::log2(idx * bin_width);
+            weights[idx] =
+                (float)(1 / (48.35 * constexpr_math::pow(log_freq, -3.434)));
+        }
+    }
+};
+
+// STFT post-processing specialised for fixed analysis sizes
+template <unsigned long WindowLength, unsigned long TransformLength,
+          unsigned long SampleRate, int NumNotes, int MinNote, int MaxNote>
+class FixedSTFT {
+   public:
+    typedef FixedSTFTTables<TransformLength, SampleRate, NumNotes, MinNote,
+                            MaxNote>
+        Tables;
+
+    static constexpr unsigned long window_length = WindowLength;
+    static constexpr unsigned long transform_length = TransformLength;
+    static constexpr unsigned long sample_rate = SampleRate;
+    static constexpr unsigned long num_raw = Tables::num_raw;
+    static constexpr int num_notes = NumNotes;
+    static constexpr int min_note = MinNote;
+    static constexpr int max_note = MaxNote;
+
+    static void map(float *raw_power, float *notes) {
+        // Only the bins feeding the interpolation need scaling
+        kernels::active().scale_power(raw_power + tables.first_bin,
+                                      tables.weights + tables.first_bin,
+                                      tables.last_bin - tables.first_bin + 1);
+
+        for (int idx = 0; idx < NumNotes; idx++) {
+            const float scale = tables.scale[idx];
+            notes[idx] = raw_power[tables.idxlow[idx]] * (1 - scale) +
+                         raw_power[tables.idxhigh[idx]] * scale;
+        }
+    }
+
+   private:
+    static constexpr Tables tables{};
+    static_assert(tables.last_bin < num_raw, "Notes exceed Nyquist frequency");
+    static_assert(tables.first_bin > 1, "Notes below lowest usable bin");
+};
+
+// Look up a compile-time specialisation matching a runtime configuration
+SpectrumMap find_fixed_stft(const SpectrogramInput &props,
+                            const SpectrogramConfig &config, int num_notes,
+                            int min_note, int max_note);
+
+#endif /* FIXED_STFT_H */
@@ -0,0 +1,123 @@
+#include "kernels.h"
+
+#include <algorithm>  // max
+#include <cmath>      // sqrt, fabs
+#include <sstream>
+
+namespace kernels {
+
+#ifdef AUDIOVIZ_X86_KERNELS
+extern const KernelTable sse4_table;
+extern const KernelTable avx2_table;
+extern const KernelTable avx512_table;
+#endif
+
+static void scale_power_scalar(float *power, const float *weights,
+                               unsigned long n) {
+    for (unsigned long idx = 0; idx < n; idx++)
+        power[idx] = std::sqrt(power[idx]) * weights[idx];
+}
+
+static void resample_scalar(const float *values, const unsigned int *low,
+                            const unsigned int *high, const float *scale,
+                            float *out, unsigned long n) {
+    for (unsigned long idx = 0; idx < n; idx++)
+        out[idx] = values[low[idx]] * (1 - scale[idx]) +
+                   values[high[idx]] * scale[idx];
+}
+
+static void deinterleave_scalar(const float *data, unsigned long stride,
+                                float *out, unsigned long n) {
+    for (unsigned long idx = 0; idx < n; idx++) out[idx] = data[idx * stride];
+}
+
+static const KernelTable scalar_table = {"scalar", scale_power_scalar,
+                                         resample_scalar, deinterleave_scalar};
+
+const KernelTable &scalar() { return scalar_table; }
+
+std::vector<const KernelTable *> available() {
+    std::vector<const KernelTable *> tables = {&scalar_table};
+#ifdef AUDIOVIZ_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) tables.push_back(&sse4_table);
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        tables.push_back(&avx2_table);
+    if (__builtin_cpu_supports("avx512f")) tables.push_back(&avx512_table);
+#endif
+    return tables;
+}
+
+const KernelTable &active() {
+    static const KernelTable &table = *available().back();
+    return table;
+}
+
+static bool compare(const char *kernel, const KernelTable *table,
+                    const std::vector<float> &expected,
+                    const std::vector<float> &actual, std::ostream &os) {
+    for (unsigned long idx = 0; idx < expected.size(); idx++) {
+        const float tolerance =
+            1e-5f * std::max(1.0f, std::fabs(expected[idx]));
+        if (std::fabs(expected[idx] - actual[idx]) > tolerance) {
+            os << table->name << " " << kernel << " differs at " << idx << ": "
+               << actual[idx] << " != " << expected[idx] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verify(std::string &report) {
+    // Odd length exercises the vector remainders
+    const unsigned long n = 1031;
+    const unsigned long stride = 3;
+
+    // Deterministic pseudo-random inputs
+    std::vector<float> data(n * stride), weights(n), scale(n);
+    std::vector<unsigned int> low(n), high(n);
+    unsigned int state = 12345;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / 16777216.0f;
+    };
+    for (auto &value : data) value = 100 * next();
+    for (unsigned long idx = 0; idx < n; idx++) {
+        weights[idx] = next();
+        scale[idx] = next();
+        low[idx] = (unsigned int)(next() * (n - 1));
+        high[idx] = low[idx] + 1;
+    }
+
+    std::ostringstream os;
+    bool all_ok = true;
+    for (const KernelTable *table : available()) {
+        bool ok = true;
+        std::vector<float> expected(data.begin(), data.begin() + n);
+        std::vector<float> actual = expected;
+        scalar_table.scale_power(expected.data(), weights.data(), n);
+        table->scale_power(actual.data(), weights.data(), n);
+        ok &= compare("scale_power", table, expected, actual, os);
+
+        scalar_table.resample(data.data(), low.data(), high.data(),
+                              scale.data(), expected.data(), n);
+        table->resample(data.data(), low.data(), high.data(), scale.data(),
+                        actual.data(), n);
+        ok &= compare("resample", table, expected, actual, os);
+
+        for (unsigned long s = 1; s <= stride; s++) {
+            scalar_table.deinterleave(data.data() + s - 1, s, expected.data(),
+                                      n);
+            table->deinterleave(data.data() + s - 1, s, actual.data(), n);
+            ok &= compare("deinterleave", table, expected, actual, os);
+        }
+
+        os << table->name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+        all_ok &= ok;
+    }
+
+    report = os.str();
+    return all_ok;
+}
+
+}  // namespace kernels
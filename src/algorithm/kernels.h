@@ -0,0 +1,41 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <string>
+#include <vector>
+
+// Hot DSP loops, with specialised implementations selected at startup
+// according to the instruction sets supported by the host CPU.
+namespace kernels {
+
+struct KernelTable {
+    const char *name;
+
+    // power[i] = sqrt(power[i]) * weights[i]
+    void (*scale_power)(float *power, const float *weights, unsigned long n);
+
+    // out[i] = values[low[i]] * (1 - scale[i]) + values[high[i]] * scale[i]
+    void (*resample)(const float *values, const unsigned int *low,
+                     const unsigned int *high, const float *scale, float *out,
+                     unsigned long n);
+
+    // out[i] = data[i * stride]
+    void (*deinterleave)(const float *data, unsigned long stride, float *out,
+                         unsigned long n);
+};
+
+// Kernel set chosen for this CPU
+const KernelTable &active();
+
+// Plain C++ reference implementation
+const KernelTable &scalar();
+
+// Every kernel set this CPU can run, scalar first
+std::vector<const KernelTable *> available();
+
+// Check that every available kernel set agrees with the scalar reference
+bool verify(std::string &report);
+
+}  // namespace kernels
+
+#endif /* KERNELS_H */
@@ -0,0 +1,60 @@
+#include <immintrin.h>
+
+#include <cmath>
+
+#include "kernels.h"
+
+namespace kernels {
+
+static void scale_power_avx2(float *power, const float *weights,
+                             unsigned long n) {
+    unsigned long idx = 0;
+    for (; idx + 8 <= n; idx += 8) {
+        __m256 p = _mm256_sqrt_ps(_mm256_loadu_ps(power + idx));
+        _mm256_storeu_ps(power + idx,
+                         _mm256_mul_ps(p, _mm256_loadu_ps(weights + idx)));
+    }
+    for (; idx < n; idx++) power[idx] = std::sqrt(power[idx]) * weights[idx];
+}
+
+static void resample_avx2(const float *values, const unsigned int *low,
+                          const unsigned int *high, const float *scale,
+                          float *out, unsigned long n) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    unsigned long idx = 0;
+    for (; idx + 8 <= n; idx += 8) {
+        __m256i low_idx = _mm256_loadu_si256((const __m256i *)(low + idx));
+        __m256i high_idx = _mm256_loadu_si256((const __m256i *)(high + idx));
+        __m256 lo = _mm256_i32gather_ps(values, low_idx, 4);
+        __m256 hi = _mm256_i32gather_ps(values, high_idx, 4);
+        __m256 s = _mm256_loadu_ps(scale + idx);
+        __m256 r =
+            _mm256_fmadd_ps(hi, s, _mm256_mul_ps(lo, _mm256_sub_ps(one, s)));
+        _mm256_storeu_ps(out + idx, r);
+    }
+    for (; idx < n; idx++)
+        out[idx] = values[low[idx]] * (1 - scale[idx]) +
+                   values[high[idx]] * scale[idx];
+}
+
+static void deinterleave_avx2(const float *data, unsigned long stride,
+                              float *out, unsigned long n) {
+    unsigned long idx = 0;
+    if (stride == 1) {
+        for (; idx + 8 <= n; idx += 8)
+            _mm256_storeu_ps(out + idx, _mm256_loadu_ps(data + idx));
+    } else {
+        const int s = (int)stride;
+        const __m256i offsets =
+            _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+        for (; idx + 8 <= n; idx += 8)
+            _mm256_storeu_ps(out + idx, _mm256_i32gather_ps(data + idx * stride,
+                                                            offsets, 4));
+    }
+    for (; idx < n; idx++) out[idx] = data[idx * stride];
+}
+
+extern const KernelTable avx2_table = {"avx2", scale_power_avx2,
+                                       resample_avx2, deinterleave_avx2};
+
+}  // namespace kernels
@@ -0,0 +1,61 @@
+#include <immintrin.h>
+
+#include <cmath>
+
+#include "kernels.h"
+
+namespace kernels {
+
+static void scale_power_avx512(float *power, const float *weights,
+                               unsigned long n) {
+    unsigned long idx = 0;
+    for (; idx + 16 <= n; idx += 16) {
+        __m512 p = _mm512_sqrt_ps(_mm512_loadu_ps(power + idx));
+        _mm512_storeu_ps(power + idx,
+                         _mm512_mul_ps(p, _mm512_loadu_ps(weights + idx)));
+    }
+    for (; idx < n; idx++) power[idx] = std::sqrt(power[idx]) * weights[idx];
+}
+
+static void resample_avx512(const float *values, const unsigned int *low,
+                            const unsigned int *high, const float *scale,
+                            float *out, unsigned long n) {
+    const __m512 one = _mm512_set1_ps(1.0f);
+    unsigned long idx = 0;
+    for (; idx + 16 <= n; idx += 16) {
+        __m512i low_idx = _mm512_loadu_si512(low + idx);
+        __m512i high_idx = _mm512_loadu_si512(high + idx);
+        __m512 lo = _mm512_i32gather_ps(low_idx, values, 4);
+        __m512 hi = _mm512_i32gather_ps(high_idx, values, 4);
+        __m512 s = _mm512_loadu_ps(scale + idx);
+        __m512 r =
+            _mm512_fmadd_ps(hi, s, _mm512_mul_ps(lo, _mm512_sub_ps(one, s)));
+        _mm512_storeu_ps(out + idx, r);
+    }
+    for (; idx < n; idx++)
+        out[idx] = values[low[idx]] * (1 - scale[idx]) +
+                   values[high[idx]] * scale[idx];
+}
+
+static void deinterleave_avx512(const float *data, unsigned long stride,
+                                float *out, unsigned long n) {
+    unsigned long idx = 0;
+    if (stride == 1) {
+        for (; idx + 16 <= n; idx += 16)
+            _mm512_storeu_ps(out + idx, _mm512_loadu_ps(data + idx));
+    } else {
+        const __m512i offsets = _mm512_mullo_epi32(
+            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                              15),
+            _mm512_set1_epi32((int)stride));
+        for (; idx + 16 <= n; idx += 16)
+            _mm512_storeu_ps(out + idx, _mm512_i32gather_ps(
+                                            offsets, data + idx * stride, 4));
+    }
+    for (; idx < n; idx++) out[idx] = data[idx * stride];
+}
+
+extern const KernelTable avx512_table = {"avx512", scale_power_avx512,
+                                         resample_avx512, deinterleave_avx512};
+
+}  // namespace kernels
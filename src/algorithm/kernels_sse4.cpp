@@ -0,0 +1,60 @@
+#include <smmintrin.h>
+
+#include <cmath>
+
+#include "kernels.h"
+
+namespace kernels {
+
+static void scale_power_sse4(float *power, const float *weights,
+                             unsigned long n) {
+    unsigned long idx = 0;
+    for (; idx + 4 <= n; idx += 4) {
+        __m128 p = _mm_sqrt_ps(_mm_loadu_ps(power + idx));
+        _mm_storeu_ps(power + idx, _mm_mul_ps(p, _mm_loadu_ps(weights + idx)));
+    }
+    for (; idx < n; idx++) power[idx] = std::sqrt(power[idx]) * weights[idx];
+}
+
+static void resample_sse4(const float *values, const unsigned int *low,
+                          const unsigned int *high, const float *scale,
+                          float *out, unsigned long n) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    unsigned long idx = 0;
+    for (; idx + 4 <= n; idx += 4) {
+        // No gather instruction, so assemble the operands lane by lane
+        __m128 lo = _mm_setr_ps(values[low[idx]], values[low[idx + 1]],
+                                values[low[idx + 2]], values[low[idx + 3]]);
+        __m128 hi = _mm_setr_ps(values[high[idx]], values[high[idx + 1]],
+                                values[high[idx + 2]], values[high[idx + 3]]);
+        __m128 s = _mm_loadu_ps(scale + idx);
+        __m128 r = _mm_add_ps(_mm_mul_ps(lo, _mm_sub_ps(one, s)),
+                              _mm_mul_ps(hi, s));
+        _mm_storeu_ps(out + idx, r);
+    }
+    for (; idx < n; idx++)
+        out[idx] = values[low[idx]] * (1 - scale[idx]) +
+                   values[high[idx]] * scale[idx];
+}
+
+static void deinterleave_sse4(const float *data, unsigned long stride,
+                              float *out, unsigned long n) {
+    unsigned long idx = 0;
+    if (stride == 2) {
+        // Stereo: pick the even lanes out of each pair of registers
+        for (; idx + 4 <= n; idx += 4) {
+            __m128 a = _mm_loadu_ps(data + 2 * idx);
+            __m128 b = _mm_loadu_ps(data + 2 * idx + 4);
+            _mm_storeu_ps(out + idx, _mm_shuffle_ps(a, b, 0x88));
+        }
+    } else if (stride == 1) {
+        for (; idx + 4 <= n; idx += 4)
+            _mm_storeu_ps(out + idx, _mm_loadu_ps(data + idx));
+    }
+    for (; idx < n; idx++) out[idx] = data[idx * stride];
+}
+
+extern const KernelTable sse4_table = {"sse4", scale_power_sse4,
+                                       resample_sse4, deinterleave_sse4};
+
+}  // namespace kernels
@@ -0,0 +1,18 @@
+#include "note_stft.h"
+
+STFT create_note_stft(unsigned long sample_rate) {
+    SpectrogramInput props;
+    props.data_size = sizeof(float);
+    props.sample_rate = sample_rate;
+    props.num_samples = note_stft::segment_length;
+    props.stride = 1;  // Not equal to # of channels since we deinterleave first
+
+    SpectrogramConfig config;
+    config.padding_mode = PAD;
+    config.window_length = note_stft::window_length;
+    config.window_overlap = note_stft::window_overlap;
+    config.transform_length = note_stft::transform_length;
+    config.window_type = note_stft::window_type;
+
+    return STFT(props, config);
+}
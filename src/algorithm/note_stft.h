@@ -0,0 +1,29 @@
+#ifndef NOTE_STFT_H
+#define NOTE_STFT_H
+
+#include <spectrogram.h>
+
+#include "stft.h"
+
+// The one analysis configuration shared by the visuals, audioviz-analyze and
+// the core library. Precomputed and published spectra can only stand in for
+// live analysis when all of them use it.
+namespace note_stft {
+
+static constexpr unsigned long segment_length = 16384;
+static constexpr unsigned long window_length = segment_length;
+static constexpr unsigned long window_overlap = 0;
+static constexpr unsigned long transform_length = 4 * window_length;
+static constexpr auto window_type = HAMMING;
+
+// Notes the spectra are resampled to, in semitones from A4
+static constexpr int min_note = -50;  // 24.4997 Hz
+static constexpr int max_note = 50;   // 7902.1328 Hz
+static constexpr int num_notes = 401;
+
+}  // namespace note_stft
+
+// Analysis of deinterleaved mono segments of segment_length samples
+STFT create_note_stft(unsigned long sample_rate);
+
+#endif /* NOTE_STFT_H */
@@ -1,11 +1,15 @@
 #include "resampler.h"
 
+#include "kernels.h"
+
 Resampler::Resampler(const std::vector<float> &known_pts,
                      const std::vector<float> &query_pts) {
     const unsigned long num_known = known_pts.size();
     const unsigned long num_query = query_pts.size();
 
-    data_.resize(num_query);
+    idxlow_.resize(num_query);
+    idxhigh_.resize(num_query);
+    scale_.resize(num_query);
 
     for (unsigned long query_idx = 0; query_idx < num_query; query_idx++) {
         const float query_pt = query_pts[query_idx];
@@ -23,19 +27,16 @@ Resampler::Resampler(const std::vector<float> &known_pts,
         }
 
         // Set the scaling values
-        data_[query_idx].idxlow = lowidx;
-        data_[query_idx].idxhigh = highidx;
-        data_[query_idx].scale = (query_pt - known_pts[lowidx]) /
-                                 (known_pts[highidx] - known_pts[lowidx]);
+        idxlow_[query_idx] = lowidx;
+        idxhigh_[query_idx] = highidx;
+        scale_[query_idx] = (query_pt - known_pts[lowidx]) /
+                            (known_pts[highidx] - known_pts[lowidx]);
     }
 }
 
 std::vector<float> Resampler::resample(const std::vector<float> &values) const {
-    std::vector<float> result(data_.size());
-    for (unsigned long idx = 0; idx < data_.size(); idx++) {
-        const interp &q = data_[idx];
-        result[idx] =
-            values[q.idxlow] * (1 - q.scale) + values[q.idxhigh] * q.scale;
-    }
+    std::vector<float> result(scale_.size());
+    kernels::active().resample(values.data(), idxlow_.data(), idxhigh_.data(),
+                               scale_.data(), result.data(), scale_.size());
     return result;
 }
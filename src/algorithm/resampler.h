@@ -3,12 +3,6 @@
 
 #include <vector>
 
-struct interp {
-    unsigned long idxlow;
-    unsigned long idxhigh;
-    float scale;
-};
-
 class Resampler {
    public:
     Resampler(){};
@@ -17,7 +11,10 @@ class Resampler {
     std::vector<float> resample(const std::vector<float> &values) const;
 
    private:
-    std::vector<interp> data_;
+    // Interpolation table, stored as separate arrays for vectorized lookup
+    std::vector<unsigned int> idxlow_;
+    std::vector<unsigned int> idxhigh_;
+    std::vector<float> scale_;
 };
 
 #endif /* RESAMPLER_H */
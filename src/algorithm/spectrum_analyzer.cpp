@@ -0,0 +1,102 @@
+#include "spectrum_analyzer.h"
+
+#include <algorithm>  // max
+#include <cmath>
+#include <utility>  // swap
+
+SpectrumAnalyzer::SpectrumAnalyzer(const IAudioSource &audio_source,
+                                   const STFT &stft)
+    : audio_source_(audio_source),
+      stft_(stft),
+      workspace_(stft) {
+    current_.left.resize(stft.length());
+    current_.right.resize(stft.length());
+}
+
+void SpectrumAnalyzer::set_rate(const double rate) {
+    rate_ = std::max(0.0, rate);
+    reset_grid();
+}
+
+void SpectrumAnalyzer::set_precomputed(const SpectraFile *spectra) {
+    spectra_ = spectra;
+    reset_grid();
+}
+
+void SpectrumAnalyzer::reset_grid() {
+    if (spectra_) {
+        hop_ = spectra_->hop();
+    } else {
+        hop_ = rate_ > 0 ? audio_source_.sample_rate() / rate_ : 0;
+    }
+
+    // Cached frames belong to the old grid
+    previous_.index = -1;
+    next_.index = -1;
+    current_valid_ = false;
+}
+
+void SpectrumAnalyzer::analyse(const unsigned long position, Frame &frame) {
+    // get_segment takes the centre of the segment, not its start
+    const unsigned long segment_length = stft_.num_samples();
+    std::vector<float> signal_left =
+        audio_source_.get_segment(0, position, segment_length);
+    std::vector<float> signal_right =
+        audio_source_.get_segment(1, position, segment_length);
+
+    // Must check size since get_segment can return a shorter vector than
+    // requested
+    if (signal_left.size() == segment_length &&
+        signal_right.size() == segment_length) {
+        frame.left = stft_.compute(signal_left, workspace_);
+        frame.right = stft_.compute(signal_right, workspace_);
+    } else {
+        frame.left.assign(stft_.length(), 0.0f);
+        frame.right.assign(stft_.length(), 0.0f);
+    }
+
+    if (publisher_) publisher_->publish(position, frame.left, frame.right);
+}
+
+void SpectrumAnalyzer::analyse_grid(const long index, Frame &frame) {
+    const unsigned long position = (unsigned long)std::llround(index * hop_);
+    if (spectra_) {
+        spectra_->read(index, frame.left, frame.right);
+        if (publisher_) publisher_->publish(position, frame.left, frame.right);
+    } else {
+        analyse(position, frame);
+    }
+    frame.index = index;
+}
+
+void SpectrumAnalyzer::update(const unsigned long position) {
+    // Paused playback redraws the same position over and over
+    if (current_valid_ && position == position_) return;
+    current_valid_ = true;
+    position_ = position;
+
+    if (hop_ <= 0) {
+        analyse(position, current_);
+        return;
+    }
+
+    // Bracket the position by two grid frames, reusing what we already have.
+    // Playing forwards this costs at most one new frame per grid step.
+    const long index = (long)std::floor(position / hop_);
+    if (previous_.index != index) {
+        if (next_.index == index) {
+            std::swap(previous_, next_);
+        } else {
+            analyse_grid(index, previous_);
+        }
+    }
+    if (next_.index != index + 1) analyse_grid(index + 1, next_);
+
+    const float t = (float)((position - index * hop_) / hop_);
+    for (unsigned long idx = 0; idx < stft_.length(); idx++) {
+        current_.left[idx] = previous_.left[idx] +
+                             t * (next_.left[idx] - previous_.left[idx]);
+        current_.right[idx] = previous_.right[idx] +
+                              t * (next_.right[idx] - previous_.right[idx]);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SPECTRUM_ANALYZER_H
+#define SPECTRUM_ANALYZER_H
+
+#include <vector>
+
+#include "audio/i_source.h"
+#include "ipc/spectrum_publisher.h"
+#include "stft.h"
+#include "store/spectra_file.h"
+
+// Stereo note spectra of an audio source around a sample position.
+//
+// By default every call runs the STFT at exactly that position. With an
+// analysis rate set, spectra are only computed on a fixed grid of that many
+// frames per second of audio, and positions in between are interpolated
+// linearly from the two nearest frames. Rendering faster than the analysis
+// rate then costs no extra transforms.
+//
+// With precomputed spectra set, the grid frames are read from the file
+// instead, at its own rate, and no transforms run at all.
+class SpectrumAnalyzer {
+   public:
+    SpectrumAnalyzer(const IAudioSource &audio_source, const STFT &stft);
+
+    // Analysis frames per second of audio, 0 analyses every call
+    void set_rate(const double rate);
+    double rate() const { return rate_; }
+
+    // Also publish every computed spectrum to other processes, null to stop
+    void set_publisher(SpectrumPublisher *publisher) { publisher_ = publisher; }
+
+    // Serve frames from spectra analysed ahead of time, null to analyse live.
+    // They must match the sample rate and STFT configuration of this analyzer.
+    void set_precomputed(const SpectraFile *spectra);
+
+    // Update the spectra to be centered on position, nothing to do if it is
+    // unchanged. They are all zero where the source has no full segment
+    // around it.
+    void update(const unsigned long position);
+    const std::vector<float> &left() const { return current_.left; }
+    const std::vector<float> &right() const { return current_.right; }
+
+   private:
+    struct Frame {
+        long index = -1;  // Position on the analysis grid, -1 if empty
+        std::vector<float> left;
+        std::vector<float> right;
+    };
+
+    // Analyse the segment centered on position into frame
+    void analyse(const unsigned long position, Frame &frame);
+    void analyse_grid(const long index, Frame &frame);
+    void reset_grid();
+
+    const IAudioSource &audio_source_;
+    const STFT &stft_;
+    STFTWorkspace workspace_;
+    double rate_ = 0;
+    double hop_ = 0;  // Samples between analysis frames
+    SpectrumPublisher *publisher_ = nullptr;
+    const SpectraFile *spectra_ = nullptr;
+
+    // The analysis frames just before and after the last position
+    Frame previous_;
+    Frame next_;
+
+    // Spectra at the last position
+    Frame current_;
+    bool current_valid_ = false;
+    unsigned long position_ = 0;
+};
+
+#endif /* SPECTRUM_ANALYZER_H */
@@ -2,24 +2,57 @@
 
 #include <algorithm>  // min,max
 #include <cmath>      // INFINITY
+#include <mutex>
+
+#include "kernels.h"
+#include "note_stft.h"
 
 // Spectrum resampling parameters
-static constexpr int min_note = -50;  // 24.4997 Hz
-static constexpr int max_note = 50;   // 7902.1328 Hz
-static constexpr int num_note = 401;
+static constexpr int min_note = note_stft::min_note;
+static constexpr int max_note = note_stft::max_note;
+static constexpr int num_note = note_stft::num_notes;
+
+// FFTW planning (done inside spectrogram_create/destroy) is not thread-safe
+static std::mutex planner_mutex;
+
+static SpectrogramTransform *create_transform(SpectrogramInput props,
+                                              SpectrogramConfig config) {
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    return spectrogram_create(&props, &config);
+}
+
+static void destroy_transform(SpectrogramTransform *transform) {
+    std::lock_guard<std::mutex> lock(planner_mutex);
+    spectrogram_destroy(transform);
+}
 
 STFT::STFT(SpectrogramInput props, SpectrogramConfig config)
     : props_(props), config_(config) {
-    // Create spectrogram object
-    transform_ = spectrogram_create(&props, &config);
+    // Create a temporary spectrogram object to query the output dimensions
+    SpectrogramTransform *transform = create_transform(props, config);
+    num_raw_frequencies_ = spectrogram_get_freqlen(transform);
+    raw_frequencies_.resize(num_raw_frequencies_);
+    spectrogram_get_freq(transform, (void *)raw_frequencies_.data());
+    destroy_transform(transform);
 
-    // Get derived output dimensions
-    num_raw_frequencies_ = spectrogram_get_freqlen(transform_);
+    // Use the precomputed tables when available, provided the transform
+    // produces the uniform frequency grid they were generated for
+    fixed_map_ = find_fixed_stft(props, config, num_note, min_note, max_note);
+    if (fixed_map_) {
+        const float bin_width =
+            (float)props.sample_rate / config.transform_length;
+        if (num_raw_frequencies_ != config.transform_length / 2 + 1 ||
+            std::abs(raw_frequencies_[1] - bin_width) > 1e-3f * bin_width)
+            fixed_map_ = nullptr;
+    }
+    if (fixed_map_) return;
 
-    // Allocate raw spectra
-    raw_frequencies_.resize(num_raw_frequencies_);
-    raw_power_.resize(num_raw_frequencies_);
-    spectrogram_get_freq(transform_, (void *)raw_frequencies_.data());
+    // Precompute the frequency-dependent scaling
+    raw_weights_.resize(num_raw_frequencies_);
+    for (unsigned long idx = 0; idx < num_raw_frequencies_; idx++) {
+        raw_weights_[idx] =
+            1 / (48.35 * pow(log2(raw_frequencies_[idx]), -3.434));
+    }
 
     // Allocate resampled spectra
     std::vector<float> frequencies(num_note);
@@ -33,21 +66,39 @@ STFT::STFT(SpectrogramInput props, SpectrogramConfig config)
     resampler_ = Resampler(raw_frequencies_, frequencies);
 }
 
-STFT::~STFT() { spectrogram_destroy(transform_); }
-
-std::vector<float> STFT::compute(std::vector<float> &signal) const {
+std::vector<float> STFT::compute(std::vector<float> &signal,
+                                 STFTWorkspace &workspace) const {
     if (signal.size() < props_.num_samples) signal.resize(props_.num_samples);
 
-    spectrogram_execute(transform_, (void *)signal.data());
-    spectrogram_get_power_periodogram(transform_, (void *)raw_power_.data());
+    std::vector<float> &raw_power = workspace.raw_power_;
+    spectrogram_execute(workspace.transform_, (void *)signal.data());
+    spectrogram_get_power_periodogram(workspace.transform_,
+                                      (void *)raw_power.data());
 
-    // Rescale based on frequency and log transform
-    for (unsigned long idx = 0; idx < num_raw_frequencies_; idx++) {
-        float scale = 1 / (48.35 * pow(log2(raw_frequencies_[idx]), -3.434));
-        raw_power_[idx] = sqrt(raw_power_[idx]) * scale;
+    if (fixed_map_) {
+        std::vector<float> result(num_note);
+        fixed_map_(raw_power.data(), result.data());
+        return result;
     }
 
-    return resampler_.resample(raw_power_);
+    // Rescale based on frequency and log transform
+    kernels::active().scale_power(raw_power.data(), raw_weights_.data(),
+                                  num_raw_frequencies_);
+
+    return resampler_.resample(raw_power);
 }
 
 unsigned long STFT::length() const { return num_note; }
+
+STFTWorkspace::STFTWorkspace(const STFT &plan)
+    : transform_(create_transform(plan.props_, plan.config_)),
+      raw_power_(plan.num_raw_frequencies_) {}
+
+STFTWorkspace::STFTWorkspace(STFTWorkspace &&other)
+    : transform_(other.transform_), raw_power_(std::move(other.raw_power_)) {
+    other.transform_ = nullptr;
+}
+
+STFTWorkspace::~STFTWorkspace() {
+    if (transform_) destroy_transform(transform_);
+}
@@ -5,27 +5,53 @@
 
 #include <vector>
 
+#include "fixed_stft.h"
 #include "resampler.h"
 
+class STFTWorkspace;
+
+// Immutable analysis plan. A single STFT can be shared between any number of
+// threads, each computing spectra through its own STFTWorkspace.
 class STFT {
    public:
     STFT(SpectrogramInput props, SpectrogramConfig config);
-    ~STFT();
 
     unsigned long length() const;
-    std::vector<float> compute(std::vector<float>& signal) const;
+    unsigned long num_samples() const { return props_.num_samples; }
+    std::vector<float> compute(std::vector<float>& signal,
+                               STFTWorkspace& workspace) const;
 
    private:
+    friend class STFTWorkspace;
+
     // Configuration
     const SpectrogramInput props_;
     const SpectrogramConfig config_;
-    SpectrogramTransform* transform_;
     Resampler resampler_;
 
-    // Temporary data
+    // Derived data
     unsigned long num_raw_frequencies_;
     std::vector<float> raw_frequencies_;
-    mutable std::vector<float> raw_power_;
+    std::vector<float> raw_weights_;
+
+    // Compile-time specialised path, if one matches the configuration
+    SpectrumMap fixed_map_ = nullptr;
+};
+
+// Per-thread scratch state for STFT::compute
+class STFTWorkspace {
+   public:
+    explicit STFTWorkspace(const STFT& plan);
+    STFTWorkspace(const STFTWorkspace&) = delete;
+    STFTWorkspace& operator=(const STFTWorkspace&) = delete;
+    STFTWorkspace(STFTWorkspace&& other);
+    ~STFTWorkspace();
+
+   private:
+    friend class STFT;
+
+    SpectrogramTransform* transform_;
+    std::vector<float> raw_power_;
 };
 
 #endif /* STFT_H */
@@ -0,0 +1,116 @@
+#include "waveform_pyramid.h"
+
+#include <algorithm>  // max, min
+#include <cmath>
+
+WaveformPyramid::WaveformPyramid(const IAudioSource &audio_source)
+    : audio_source_(audio_source),
+      num_channels_(audio_source.num_channels()),
+      num_samples_(audio_source.num_samples()) {
+    if (num_channels_ == 0 || num_samples_ == 0) return;
+
+    // Level 0 straight from the interleaved samples
+    const std::vector<float> &data = audio_source_.data();
+    const unsigned long num_blocks =
+        (num_samples_ + base_block - 1) / base_block;
+    std::vector<Block> level(num_blocks * num_channels_);
+    for (unsigned long block = 0; block < num_blocks; block++) {
+        const unsigned long first = block * base_block;
+        const unsigned long last = std::min(first + base_block, num_samples_);
+        for (unsigned long ch = 0; ch < num_channels_; ch++) {
+            Block summary = {INFINITY, -INFINITY, 0.0f};
+            for (unsigned long idx = first; idx < last; idx++) {
+                const float value = data[idx * num_channels_ + ch];
+                summary.min = std::min(summary.min, value);
+                summary.max = std::max(summary.max, value);
+                summary.sum_squares += value * value;
+            }
+            level[block * num_channels_ + ch] = summary;
+        }
+    }
+    levels_.push_back(std::move(level));
+
+    // Merge pairs until one block covers the whole track
+    while (levels_.back().size() > num_channels_) {
+        const std::vector<Block> &below = levels_.back();
+        const unsigned long below_blocks = below.size() / num_channels_;
+        std::vector<Block> above((below_blocks + 1) / 2 * num_channels_);
+        for (unsigned long block = 0; block < below_blocks; block++) {
+            for (unsigned long ch = 0; ch < num_channels_; ch++) {
+                const Block &child = below[block * num_channels_ + ch];
+                Block &parent = above[block / 2 * num_channels_ + ch];
+                if (block % 2 == 0) {
+                    parent = child;
+                } else {
+                    parent.min = std::min(parent.min, child.min);
+                    parent.max = std::max(parent.max, child.max);
+                    parent.sum_squares += child.sum_squares;
+                }
+            }
+        }
+        levels_.push_back(std::move(above));
+    }
+}
+
+WaveformPyramid::Range WaveformPyramid::range(unsigned long channel,
+                                              long first, long last) const {
+    first = std::max(first, 0L);
+    last = std::min(last, (long)num_samples_);
+    Range result;
+    if (first >= last || channel >= num_channels_) return result;
+
+    float min = INFINITY;
+    float max = -INFINITY;
+    double sum_squares = 0;
+    const std::vector<float> &data = audio_source_.data();
+    auto add_samples = [&](unsigned long from, unsigned long to) {
+        for (unsigned long idx = from; idx < to; idx++) {
+            const float value = data[idx * num_channels_ + channel];
+            min = std::min(min, value);
+            max = std::max(max, value);
+            sum_squares += value * value;
+        }
+    };
+
+    // Raw samples up to the first block boundary
+    unsigned long position = first;
+    const unsigned long end = last;
+    const unsigned long head =
+        std::min(end, (position + base_block - 1) / base_block * base_block);
+    add_samples(position, head);
+    position = head;
+
+    // Then the largest blocks that start here and end within the range. The
+    // last block of the track counts as whole, it ends at the track end.
+    // Block sizes first only grow and then only shrink, so the level carries
+    // over from one block to the next and is walked up and down once.
+    unsigned long level = 0;
+    unsigned long size = base_block;
+    while (position < end) {
+        while (level + 1 < levels_.size() && position % (2 * size) == 0 &&
+               std::min(position + 2 * size, num_samples_) <= end) {
+            level++;
+            size *= 2;
+        }
+        while (level > 0 && std::min(position + size, num_samples_) > end) {
+            level--;
+            size /= 2;
+        }
+        if (std::min(position + size, num_samples_) > end) break;
+
+        const Block &block =
+            levels_[level][position / size * num_channels_ + channel];
+        min = std::min(min, block.min);
+        max = std::max(max, block.max);
+        sum_squares += block.sum_squares;
+        position += size;
+    }
+
+    // And raw samples after the last whole block
+    add_samples(position, end);
+
+    result.min = min;
+    result.max = max;
+    result.rms = std::sqrt(sum_squares / (last - first));
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef WAVEFORM_PYRAMID_H
+#define WAVEFORM_PYRAMID_H
+
+#include <vector>
+
+#include "audio/i_source.h"
+
+// Min, max and RMS of the decoded audio over any range of samples, without
+// touching every sample in it.
+//
+// Level 0 summarises blocks of base_block samples per channel, and every
+// level above merges pairs of blocks of the one below. A range is covered by
+// the largest aligned blocks that fit, at most two per level, plus fewer
+// than base_block raw samples at either end. Queries are exact and cost
+// O(log(length) + base_block) however long the range, and the pyramid needs
+// under a fifth of the memory of the decoded audio.
+class WaveformPyramid {
+   public:
+    struct Range {
+        float min = 0;
+        float max = 0;
+        float rms = 0;
+    };
+
+    // Summarises the source as it is now, it must stay loaded
+    explicit WaveformPyramid(const IAudioSource &audio_source);
+
+    unsigned long num_levels() const { return levels_.size(); }
+
+    // Samples [first, last) of channel, clipped to the track. Empty ranges
+    // are silent.
+    Range range(unsigned long channel, long first, long last) const;
+
+   private:
+    static constexpr unsigned long base_block = 32;
+
+    struct Block {
+        float min;
+        float max;
+        float sum_squares;
+    };
+
+    const IAudioSource &audio_source_;
+    const unsigned long num_channels_;
+    const unsigned long num_samples_;
+
+    // levels_[level][block * num_channels + channel], blocks of
+    // base_block << level samples, the last one of each level may be short
+    std::vector<std::vector<Block>> levels_;
+};
+
+#endif /* WAVEFORM_PYRAMID_H */
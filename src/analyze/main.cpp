@@ -0,0 +1,303 @@
+// Batch analysis of whole catalogues without a window or GL. Files are
+// decoded on a work-stealing pool, and the spectra of each file are computed
+// in chunks of audio on the same pool, so both many small files and a few
+// long ones keep every core busy. Each input gets a <name>.spectra file in
+// the format of store/spectra_file.h, ready for audioviz --spectra.
+
+#include <unistd.h>  // unlink
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>  // tolower
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "algorithm/note_stft.h"
+#include "algorithm/spectrum_analyzer.h"
+#include "analyze/thread_pool.h"
+#include "audio/file_source.h"
+#include "store/spectra_file.h"
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t num_channels = 2;
+static constexpr uint32_t frames_per_block = 256;
+
+struct Options {
+    std::string output_dir;  // Next to each input if empty
+    unsigned threads = 0;
+    double rate = 60;    // Frames per second of audio
+    double chunk = 30;   // Seconds of audio per task
+    uint32_t precision = 8;  // Bits per stored value
+};
+
+// One input file, shared by the tasks analysing its chunks
+struct Job {
+    std::string input;
+    std::string output;
+    FileAudioSource source;
+    std::unique_ptr<STFT> stft;
+    double hop = 0;
+    unsigned long num_frames = 0;
+    std::unique_ptr<SpectraWriter> writer;
+    std::atomic<unsigned long> chunks_left{0};
+    std::atomic<bool> failed{false};
+};
+
+// Totals over all files
+struct Progress {
+    std::mutex mutex;  // Serialises the report lines
+    std::atomic<unsigned long> done{0};
+    std::atomic<unsigned long> failed{0};
+    std::atomic<double> audio_seconds{0};
+};
+
+static bool is_audio_file(const fs::path &path) {
+    static const char *const extensions[] = {
+        ".aac", ".aif", ".aiff", ".alac", ".ape", ".flac", ".m4a",
+        ".mka", ".mp2", ".mp3",  ".ogg",  ".opus", ".wav", ".wma"};
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   ::tolower);
+    for (const char *known : extensions)
+        if (extension == known) return true;
+    return false;
+}
+
+// Files are taken as given, directories are searched for audio files
+static std::vector<std::string> collect_inputs(
+    const std::vector<std::string> &arguments) {
+    std::vector<std::string> inputs;
+    for (const std::string &argument : arguments) {
+        std::error_code error;
+        if (!fs::is_directory(argument, error)) {
+            inputs.push_back(argument);
+            continue;
+        }
+
+        std::vector<std::string> found;
+        for (fs::recursive_directory_iterator it(
+                 argument, fs::directory_options::skip_permission_denied,
+                 error),
+             end;
+             it != end; it.increment(error)) {
+            if (error) break;
+            if (it->is_regular_file(error) && is_audio_file(it->path()))
+                found.push_back(it->path().string());
+        }
+        std::sort(found.begin(), found.end());
+        inputs.insert(inputs.end(), found.begin(), found.end());
+    }
+    return inputs;
+}
+
+static std::string output_filename(const std::string &input,
+                                   const Options &options) {
+    fs::path path(input);
+    path += ".spectra";
+    if (options.output_dir.empty()) return path.string();
+    return (fs::path(options.output_dir) / path.filename()).string();
+}
+
+static void report(Progress &progress, const char *status,
+                   const std::string &name, const std::string &detail) {
+    std::lock_guard<std::mutex> lock(progress.mutex);
+    fprintf(stderr, "%-6s %s%s\n", status, name.c_str(), detail.c_str());
+}
+
+static void finish_job(Job &job, Progress &progress) {
+    if (!job.failed) {
+        try {
+            job.writer->finish();
+        } catch (const std::exception &) {
+            job.failed = true;
+        }
+    }
+    job.writer.reset();
+    if (job.failed) {
+        unlink(job.output.c_str());
+        progress.failed++;
+        report(progress, "failed", job.input,
+               std::string(": could not write ") + job.output);
+        return;
+    }
+
+    const double seconds =
+        (double)job.source.num_samples() / job.source.sample_rate();
+    double total = progress.audio_seconds.load();
+    while (!progress.audio_seconds.compare_exchange_weak(total,
+                                                         total + seconds)) {
+    }
+    progress.done++;
+    report(progress, "done", job.output, "");
+}
+
+// Analyse frames [first, last) of the job and write them in place. The
+// chunk starts on a block boundary.
+static void analyse_chunk(Job &job, unsigned long first, unsigned long last) {
+    const unsigned long num_notes = job.stft->length();
+    const size_t frame_values = num_channels * num_notes;
+    std::vector<float> frames((last - first) * frame_values);
+
+    SpectrumAnalyzer analyzer(job.source, *job.stft);
+    float *out = frames.data();
+    for (unsigned long frame = first; frame < last; frame++) {
+        analyzer.update((unsigned long)std::llround(frame * job.hop));
+        out = std::copy(analyzer.left().begin(), analyzer.left().end(), out);
+        out = std::copy(analyzer.right().begin(), analyzer.right().end(), out);
+    }
+
+    try {
+        for (unsigned long frame = first; frame < last;
+             frame += frames_per_block)
+            job.writer->write_block(frame / frames_per_block,
+                                    &frames[(frame - first) * frame_values]);
+    } catch (const std::exception &) {
+        job.failed = true;
+    }
+}
+
+// Decode a file, then split its analysis into chunks on the pool
+static void start_job(const std::shared_ptr<Job> &job, const Options &options,
+                      ThreadPool &pool, Progress &progress) {
+    try {
+        job->source.open(job->input);
+    } catch (const AudioSourceError &e) {
+        progress.failed++;
+        report(progress, "failed", job->input, std::string(": ") + e.what());
+        return;
+    }
+
+    const unsigned long sample_rate = job->source.sample_rate();
+    job->stft = std::make_unique<STFT>(create_note_stft(sample_rate));
+    job->hop = sample_rate / options.rate;
+    // Up to and including the end, so every position has frames either side
+    job->num_frames =
+        (unsigned long)std::floor(job->source.num_samples() / job->hop) + 1;
+
+    SpectraFileHeader header = {};
+    header.sample_rate = sample_rate;
+    header.window_length = note_stft::window_length;
+    header.transform_length = note_stft::transform_length;
+    header.window_type = note_stft::window_type;
+    header.num_channels = num_channels;
+    header.num_notes = job->stft->length();
+    header.min_note = note_stft::min_note;
+    header.max_note = note_stft::max_note;
+    header.value_size = options.precision / 8;
+    header.hop = job->hop;
+    header.num_frames = job->num_frames;
+    header.frames_per_block = frames_per_block;
+    try {
+        job->writer = std::make_unique<SpectraWriter>(job->output, header);
+    } catch (const std::exception &e) {
+        progress.failed++;
+        report(progress, "failed", job->input, std::string(": ") + e.what());
+        return;
+    }
+
+    // Whole blocks per chunk, so each block is quantised by one task
+    const unsigned long blocks_per_chunk = std::max(
+        1ul, (unsigned long)std::lround(options.chunk * options.rate /
+                                        frames_per_block));
+    const unsigned long frames_per_chunk = blocks_per_chunk * frames_per_block;
+    const unsigned long num_chunks =
+        std::max(1ul, (job->num_frames + frames_per_chunk - 1) /
+                          frames_per_chunk);
+    job->chunks_left = num_chunks;
+    for (unsigned long chunk = 0; chunk < num_chunks; chunk++) {
+        const unsigned long first = chunk * frames_per_chunk;
+        const unsigned long last =
+            std::min(job->num_frames, first + frames_per_chunk);
+        pool.submit([job, first, last, &progress]() {
+            analyse_chunk(*job, first, last);
+            if (--job->chunks_left == 0) finish_job(*job, progress);
+        });
+    }
+}
+
+static void print_usage() {
+    fprintf(stderr,
+            "Usage: audioviz-analyze [options] <file or directory>...\n\n"
+            "Writes the note spectra of every audio file to "
+            "<file>.spectra.\n\n"
+            "Options:\n"
+            "  --output <dir>     Write the results here instead of next "
+            "to the inputs\n"
+            "  --threads <count>  Worker threads (default one per core)\n"
+            "  --rate <hz>        Frames per second of audio (default 60)\n"
+            "  --chunk <seconds>  Audio per task within a file "
+            "(default 30)\n"
+            "  --precision <bits> Bits per stored value, 8 or 16 "
+            "(default 8)\n");
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--output" && has_value) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--rate" && has_value) {
+            options.rate = atof(argv[++i]);
+        } else if (arg == "--chunk" && has_value) {
+            options.chunk = atof(argv[++i]);
+        } else if (arg == "--precision" && has_value) {
+            options.precision = atoi(argv[++i]);
+        } else if (arg[0] == '-') {
+            print_usage();
+            return EXIT_FAILURE;
+        } else {
+            arguments.push_back(arg);
+        }
+    }
+    if (arguments.empty() || options.rate <= 0 || options.chunk <= 0 ||
+        (options.precision != 8 && options.precision != 16)) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (!options.output_dir.empty()) {
+        std::error_code error;
+        fs::create_directories(options.output_dir, error);
+    }
+
+    const std::vector<std::string> inputs = collect_inputs(arguments);
+    const auto start = std::chrono::steady_clock::now();
+    Progress progress;
+    {
+        ThreadPool pool(options.threads);
+        for (const std::string &input : inputs) {
+            auto job = std::make_shared<Job>();
+            job->input = input;
+            job->output = output_filename(input, options);
+            pool.submit([job, &options, &pool, &progress]() {
+                start_job(job, options, pool, progress);
+            });
+        }
+        pool.wait();
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const double audio_hours = progress.audio_seconds / 3600;
+    printf(
+        "Analysed %lu of %zu files: %.2f h of audio in %.1f s, "
+        "%.4f audio-hours per wall-second\n",
+        progress.done.load(), inputs.size(), audio_hours, elapsed.count(),
+        audio_hours / std::max(elapsed.count(), 1e-9));
+
+    return progress.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,102 @@
+#include "thread_pool.h"
+
+// Queue of the worker running on this thread, if any
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local unsigned current_queue = 0;
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+
+    for (unsigned idx = 0; idx < num_threads; idx++)
+        queues_.push_back(std::make_unique<Queue>());
+    for (unsigned idx = 0; idx < num_threads; idx++)
+        threads_.emplace_back(&ThreadPool::run, this, idx);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread &thread : threads_) thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unsigned index = current_queue;
+        if (current_pool != this) {
+            index = next_queue_;
+            next_queue_ = (next_queue_ + 1) % queues_.size();
+        }
+
+        Queue &queue = *queues_[index];
+        std::lock_guard<std::mutex> queue_lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queued_++;
+        unfinished_++;
+    }
+    work_available_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool ThreadPool::take(unsigned index, std::function<void()> &task) {
+    // Newest task of our own queue first
+    {
+        Queue &queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise the oldest task of the next busy worker
+    for (unsigned offset = 1; offset < queues_.size(); offset++) {
+        Queue &queue = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned index) {
+    current_pool = this;
+    current_queue = index;
+
+    std::function<void()> task;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_available_.wait(lock,
+                                 [this] { return stop_ || queued_ > 0; });
+            if (stop_ && queued_ == 0) return;
+        }
+
+        // Another worker may have been quicker. submit() queues and counts a
+        // task in one step, so queued_ never runs ahead of the queues.
+        if (!take(index, task)) continue;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_--;
+        }
+
+        task();
+        task = nullptr;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--unfinished_ == 0) all_done_.notify_all();
+    }
+}
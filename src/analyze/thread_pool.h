@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker has its own queue: tasks submitted
+// from a worker go to the back of its queue and it takes its newest task
+// first, which keeps a file's data hot while its chunks are analysed. Idle
+// workers steal the oldest task of another queue, so large jobs spread over
+// all cores once the small ones run out. Tasks must not throw.
+class ThreadPool {
+   public:
+    // 0 threads means one per core
+    explicit ThreadPool(unsigned num_threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Thread-safe, also from within a running task
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task, including ones submitted by tasks,
+    // has finished
+    void wait();
+
+    unsigned size() const { return threads_.size(); }
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    // Counters for sleeping and waiting, the queues have their own locks
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    size_t queued_ = 0;      // Tasks in any queue
+    size_t unfinished_ = 0;  // Tasks queued or running
+    unsigned next_queue_ = 0;
+    bool stop_ = false;
+
+    void run(unsigned index);
+    bool take(unsigned index, std::function<void()> &task);
+};
+
+#endif /* THREAD_POOL_H */
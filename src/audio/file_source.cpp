@@ -3,6 +3,8 @@
 #include <algorithm>  // min, max
 #include <sstream>
 
+#include "algorithm/kernels.h"
+
 FileAudioSource::FileAudioSource() {
     format = avformat_alloc_context();
     context = avcodec_alloc_context3(NULL);
@@ -120,8 +122,9 @@ void FileAudioSource::open(std::string filename) {
         av_packet_unref(packet);
     }
 
-    // Set stream properties
-    num_channels_ = stream->codecpar->channels;
+    // Set stream properties. The resampler mixed every layout to stereo, so
+    // that is what data_ holds whatever the file has.
+    num_channels_ = 2;
     num_samples_ = newsize / num_channels_;
     sample_rate_ = stream->codecpar->sample_rate;
     filename_ = filename;
@@ -140,7 +143,7 @@ std::vector<float> FileAudioSource::get_segment(const int channel,
                                                 const long center,
                                                 const long width) const {
     unsigned int real_channel = channel;
-    if (real_channel > num_channels_) real_channel = 0;
+    if (real_channel >= num_channels_) real_channel = 0;
 
     // Check bounds of window
     long start = center - width / 2;
@@ -154,10 +157,9 @@ std::vector<float> FileAudioSource::get_segment(const int channel,
 
     // Create output
     std::vector<float> window(real_width);
-    for (long idx = 0; idx < real_width; idx++) {
-        long sample = start + idx;
-        window[idx] = data_[num_channels_ * sample + real_channel];
-    }
+    kernels::active().deinterleave(
+        data_.data() + num_channels_ * start + real_channel, num_channels_,
+        window.data(), real_width);
 
     return window;
 }
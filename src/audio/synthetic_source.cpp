@@ -0,0 +1,71 @@
+#include "synthetic_source.h"
+
+#include <algorithm>  // min, max
+#include <cmath>
+#include <sstream>
+
+#include "algorithm/kernels.h"
+
+// A minor chord on the left, its fifth on the right, in Hz
+static const double left_tones[] = {220.0, 261.63, 329.63};
+static const double right_tones[] = {329.63, 392.0, 493.88};
+
+SyntheticAudioSource::SyntheticAudioSource(const unsigned long sample_rate,
+                                           const unsigned long seconds)
+    : sample_rate_(sample_rate), num_samples_(sample_rate * seconds) {
+    data_.resize(2 * num_samples_);
+    for (unsigned long idx = 0; idx < num_samples_; idx++) {
+        const double t = (double)idx / sample_rate_;
+        double left = 0;
+        double right = 0;
+        for (int tone = 0; tone < 3; tone++) {
+            // Fundamental plus two weaker harmonics
+            for (int harmonic = 1; harmonic <= 3; harmonic++) {
+                const double amplitude = 0.15 / harmonic;
+                left += amplitude *
+                        sin(2 * M_PI * harmonic * left_tones[tone] * t);
+                right += amplitude *
+                         sin(2 * M_PI * harmonic * right_tones[tone] * t);
+            }
+        }
+        data_[2 * idx] = left;
+        data_[2 * idx + 1] = right;
+    }
+}
+
+std::vector<float> SyntheticAudioSource::get_segment(const int channel,
+                                                     const long center,
+                                                     const long width) const {
+    const unsigned long real_channel = (channel == 1) ? 1 : 0;
+
+    // Check bounds of window, as FileAudioSource does
+    long start = center - width / 2;
+    start = std::max(start, (long)0);
+    start = std::min(start, (long)num_samples_ - width - 1);
+    start = std::max(start, (long)0);
+
+    long end = start + width;
+    end = std::min(end, (long)num_samples_);
+
+    long real_width = end - start;
+
+    // Create output
+    std::vector<float> window(real_width);
+    kernels::active().deinterleave(data_.data() + 2 * start + real_channel, 2,
+                                   window.data(), real_width);
+
+    return window;
+}
+
+std::string SyntheticAudioSource::info() const {
+    std::ostringstream os;
+    os << "Synthetic chord" << std::endl;
+    os << "# of samples:  " << num_samples_ << std::endl;
+    os << "# of channels: " << 2 << std::endl;
+    os << "Sample rate:   " << sample_rate_ << std::endl;
+    return os.str();
+}
+
+std::string SyntheticAudioSource::description() const {
+    return "Synthetic chord";
+}
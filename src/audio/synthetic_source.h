@@ -0,0 +1,41 @@
+#ifndef SYNTHETIC_AUDIO_SOURCE_H
+#define SYNTHETIC_AUDIO_SOURCE_H
+
+#include <string>
+#include <vector>
+
+#include "i_source.h"
+
+// Deterministic stereo chord with harmonics, for benchmarks and golden-frame
+// checks that must not depend on an audio file or decoder
+class SyntheticAudioSource : public IAudioSource {
+   public:
+    SyntheticAudioSource(const unsigned long sample_rate,
+                         const unsigned long seconds);
+
+    // Query state
+    bool loaded() const override { return true; };
+
+    // Query audio file properties
+    unsigned long num_channels() const override { return 2; };
+    unsigned long num_samples() const override { return num_samples_; };
+    unsigned long sample_rate() const override { return sample_rate_; };
+    std::string info() const override;
+
+    // Get pointer to audio data
+    const std::vector<float> &data() const override { return data_; };
+    std::vector<float> get_segment(const int channel, const long center,
+                                   const long width) const override;
+
+    // Query metadata
+    std::string description() const override;
+
+   private:
+    const unsigned long sample_rate_;
+    const unsigned long num_samples_;
+
+    // Interleaved audio data
+    std::vector<float> data_;
+};
+
+#endif /* SYNTHETIC_AUDIO_SOURCE_H */
@@ -0,0 +1,278 @@
+// Microbenchmarks for the decode and DSP hot paths. Links no SDL or GL so it
+// can run on build hosts without a display. Every result is printed as one
+// JSON object per line:
+//
+//   {"benchmark":"stft_compute","params":{...},"kernels":"avx2",
+//    "iterations":N,"median_ns":...,"mean_ns":...,"min_ns":...}
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "algorithm/kernels.h"
+#include "algorithm/resampler.h"
+#include "algorithm/stft.h"
+#include "audio/file_source.h"
+
+struct Options {
+    double min_time = 0.25;  // Seconds spent measuring each case
+    std::string filter;      // Only run benchmarks containing this
+};
+
+static Options options;
+
+// Measure fn until min_time has passed and print its statistics
+static void run(const std::string &benchmark, const std::string &params,
+                const std::function<void()> &fn) {
+    if (benchmark.find(options.filter) == std::string::npos) return;
+
+    using clock = std::chrono::steady_clock;
+    fn();  // Warm up caches and lazily initialised state
+
+    std::vector<double> samples;
+    const auto deadline =
+        clock::now() + std::chrono::duration<double>(options.min_time);
+    do {
+        const auto start = clock::now();
+        fn();
+        const auto stop = clock::now();
+        samples.push_back(
+            std::chrono::duration<double, std::nano>(stop - start).count());
+    } while (clock::now() < deadline || samples.size() < 3);
+
+    double total = 0;
+    for (double sample : samples) total += sample;
+    std::sort(samples.begin(), samples.end());
+
+    printf(
+        "{\"benchmark\":\"%s\",\"params\":{%s},\"kernels\":\"%s\","
+        "\"iterations\":%zu,\"median_ns\":%.0f,\"mean_ns\":%.0f,"
+        "\"min_ns\":%.0f}\n",
+        benchmark.c_str(), params.c_str(), kernels::active().name,
+        samples.size(), samples[samples.size() / 2], total / samples.size(),
+        samples[0]);
+    fflush(stdout);
+}
+
+// Deterministic multi-tone test signal, interleaved
+static std::vector<float> synthesize(unsigned long num_channels,
+                                     unsigned long sample_rate,
+                                     unsigned long num_samples) {
+    std::vector<float> data(num_channels * num_samples);
+    for (unsigned long idx = 0; idx < num_samples; idx++) {
+        const double t = (double)idx / sample_rate;
+        for (unsigned long ch = 0; ch < num_channels; ch++) {
+            const double f = 110.0 * (ch + 1);
+            data[idx * num_channels + ch] =
+                0.5 * sin(2 * M_PI * f * t) + 0.25 * sin(2 * M_PI * 3 * f * t);
+        }
+    }
+    return data;
+}
+
+static void put_u32(FILE *file, uint32_t value) {
+    unsigned char bytes[4] = {(unsigned char)value,
+                              (unsigned char)(value >> 8),
+                              (unsigned char)(value >> 16),
+                              (unsigned char)(value >> 24)};
+    fwrite(bytes, 1, 4, file);
+}
+
+static void put_u16(FILE *file, uint16_t value) {
+    unsigned char bytes[2] = {(unsigned char)value,
+                              (unsigned char)(value >> 8)};
+    fwrite(bytes, 1, 2, file);
+}
+
+// Write a 16-bit PCM WAV file for the decoder benchmark
+static bool write_wav(const std::string &filename,
+                      const std::vector<float> &data,
+                      unsigned long num_channels, unsigned long sample_rate) {
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) return false;
+
+    const uint32_t data_size = data.size() * sizeof(int16_t);
+    fwrite("RIFF", 1, 4, file);
+    put_u32(file, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, file);
+    put_u32(file, 16);
+    put_u16(file, 1);  // PCM
+    put_u16(file, num_channels);
+    put_u32(file, sample_rate);
+    put_u32(file, sample_rate * num_channels * sizeof(int16_t));
+    put_u16(file, num_channels * sizeof(int16_t));
+    put_u16(file, 16);
+    fwrite("data", 1, 4, file);
+    put_u32(file, data_size);
+    for (float value : data) put_u16(file, (int16_t)(value * 32767));
+
+    return fclose(file) == 0;
+}
+
+static std::string temp_filename(const char *suffix) {
+    const char *dir = getenv("TMPDIR");
+    return std::string(dir ? dir : "/tmp") + "/audioviz_bench_" +
+           std::to_string(getpid()) + suffix;
+}
+
+static void bench_decode() {
+    const unsigned long seconds = 10;
+    // Channels of the file, the decoder mixes every layout to stereo
+    for (unsigned long num_channels : {1, 2, 6}) {
+        for (unsigned long sample_rate : {44100, 48000, 96000}) {
+            const std::string filename = temp_filename(".wav");
+            if (!write_wav(filename,
+                           synthesize(num_channels, sample_rate,
+                                      seconds * sample_rate),
+                           num_channels, sample_rate)) {
+                fprintf(stderr, "Could not write %s\n", filename.c_str());
+                return;
+            }
+
+            const std::string params =
+                "\"channels\":" + std::to_string(num_channels) +
+                ",\"sample_rate\":" + std::to_string(sample_rate) +
+                ",\"seconds\":" + std::to_string(seconds);
+            try {
+                run("file_source_open", params, [&] {
+                    FileAudioSource source;
+                    source.open(filename);
+                });
+            } catch (const AudioSourceError &e) {
+                fprintf(stderr, "%s\n", e.what());
+            }
+            remove(filename.c_str());
+        }
+    }
+}
+
+static void bench_get_segment() {
+    // Files are always decoded to interleaved stereo, so the channel count of
+    // the file makes no difference here
+    const unsigned long sample_rate = 44100;
+    const unsigned long num_channels = 2;
+
+    // Decode a short file once, get_segment only reads the decoded data
+    const std::string filename = temp_filename(".wav");
+    write_wav(filename, synthesize(num_channels, sample_rate, 4 * sample_rate),
+              num_channels, sample_rate);
+    FileAudioSource source;
+    try {
+        source.open(filename);
+    } catch (const AudioSourceError &e) {
+        fprintf(stderr, "%s\n", e.what());
+        remove(filename.c_str());
+        return;
+    }
+    remove(filename.c_str());
+
+    for (long width : {1024, 4096, 16384, 65536}) {
+        const std::string params = "\"width\":" + std::to_string(width);
+        const long center = source.num_samples() / 2;
+        run("get_segment", params, [&] {
+            std::vector<float> segment =
+                source.get_segment(num_channels - 1, center, width);
+            if (segment.empty()) abort();
+        });
+    }
+}
+
+static void bench_stft() {
+    for (unsigned long sample_rate : {44100, 48000, 96000}) {
+        for (unsigned long window_length : {4096, 16384}) {
+            for (unsigned long factor : {1, 4}) {
+                SpectrogramInput props;
+                props.data_size = sizeof(float);
+                props.sample_rate = sample_rate;
+                props.num_samples = window_length;
+                props.stride = 1;
+
+                SpectrogramConfig config;
+                config.padding_mode = PAD;
+                config.window_length = window_length;
+                config.window_overlap = 0;
+                config.transform_length = factor * window_length;
+                config.window_type = HAMMING;
+
+                const STFT stft(props, config);
+                STFTWorkspace workspace(stft);
+                std::vector<float> signal =
+                    synthesize(1, sample_rate, window_length);
+
+                const std::string params =
+                    "\"sample_rate\":" + std::to_string(sample_rate) +
+                    ",\"window\":" + std::to_string(window_length) +
+                    ",\"transform\":" +
+                    std::to_string(factor * window_length);
+                run("stft_compute", params, [&] {
+                    std::vector<float> power = stft.compute(signal, workspace);
+                    if (power.empty()) abort();
+                });
+            }
+        }
+    }
+}
+
+static void bench_resample() {
+    for (unsigned long num_known : {4096, 32768}) {
+        for (unsigned long num_query : {401, 4096}) {
+            // Log-spaced queries over a linear grid, as in the STFT
+            std::vector<float> known(num_known);
+            for (unsigned long idx = 0; idx < num_known; idx++)
+                known[idx] = idx;
+            std::vector<float> query(num_query);
+            for (unsigned long idx = 0; idx < num_query; idx++)
+                query[idx] = pow(num_known - 1, (double)idx / num_query);
+
+            const Resampler resampler(known, query);
+            std::vector<float> values = synthesize(1, 44100, num_known);
+
+            const std::string params =
+                "\"known\":" + std::to_string(num_known) +
+                ",\"query\":" + std::to_string(num_query);
+            run("resample", params, [&] {
+                std::vector<float> out = resampler.resample(values);
+                if (out.empty()) abort();
+            });
+        }
+    }
+}
+
+static void print_usage() {
+    fprintf(stderr,
+            "Usage: audioviz_bench [options]\n\n"
+            "Options:\n"
+            "  --filter <name>   Only run benchmarks whose name contains this\n"
+            "  --min-time <s>    Seconds to measure each case "
+            "(default 0.25)\n");
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = atof(argv[++i]);
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    bench_decode();
+    bench_get_segment();
+    bench_stft();
+    bench_resample();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/*
+ * C interface to the headless analysis library (libaudioviz_core), for
+ * services that are not written in C++. It wraps core/core.h: no SDL, GL or
+ * display is involved, and no other audioviz headers are needed.
+ *
+ * Functions returning int give 0 on success and -1 on failure, and those
+ * returning pointers give NULL. audioviz_last_error() then describes the
+ * last failure on the calling thread.
+ *
+ *     audioviz_track *track = audioviz_track_open("song.flac");
+ *     if (!track) ... audioviz_last_error() ...;
+ *     audioviz_analyzer *analyzer = audioviz_analyzer_create(track);
+ *
+ *     const float *left, *right;
+ *     audioviz_analyse(analyzer, position, &left, &right);
+ *     ... audioviz_analyzer_num_notes(analyzer) values each ...
+ *
+ *     audioviz_stream(analyzer, 60.0, 0, audioviz_track_num_samples(track),
+ *                     callback, user_data);
+ *
+ *     audioviz_analyzer_destroy(analyzer);
+ *     audioviz_track_close(track);
+ */
+
+#ifndef AUDIOVIZ_H
+#define AUDIOVIZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct audioviz_track audioviz_track;
+typedef struct audioviz_analyzer audioviz_analyzer;
+
+/*
+ * Called for each spectrum of a stream with num_notes values per channel,
+ * valid only during the call. Return nonzero to stop the stream.
+ */
+typedef int (*audioviz_spectrum_callback)(void *user_data,
+                                          unsigned long position,
+                                          const float *left,
+                                          const float *right,
+                                          unsigned long num_notes);
+
+/* Description of the last failure on this thread, "" if none */
+const char *audioviz_last_error(void);
+
+/* Decode a whole audio file into memory */
+audioviz_track *audioviz_track_open(const char *filename);
+void audioviz_track_close(audioviz_track *track);
+unsigned long audioviz_track_num_channels(const audioviz_track *track);
+unsigned long audioviz_track_num_samples(const audioviz_track *track);
+unsigned long audioviz_track_sample_rate(const audioviz_track *track);
+
+/*
+ * Analyzers must be destroyed before their track. Each one is used by one
+ * thread at a time; create one per thread to analyse in parallel.
+ */
+audioviz_analyzer *audioviz_analyzer_create(const audioviz_track *track);
+void audioviz_analyzer_destroy(audioviz_analyzer *analyzer);
+unsigned long audioviz_analyzer_num_notes(const audioviz_analyzer *analyzer);
+int audioviz_analyzer_min_note(const audioviz_analyzer *analyzer);
+int audioviz_analyzer_max_note(const audioviz_analyzer *analyzer);
+
+/*
+ * Analysis frames per second of audio, 0 analyses every position exactly.
+ * Otherwise positions between frames are interpolated.
+ */
+int audioviz_analyzer_set_rate(audioviz_analyzer *analyzer, double rate);
+
+/*
+ * Spectra centred on a sample position, num_notes values per channel, valid
+ * until the next call on this analyzer
+ */
+int audioviz_analyse(audioviz_analyzer *analyzer, unsigned long position,
+                     const float **left, const float **right);
+
+/*
+ * Analyse positions [first, last) at rate frames per second of audio and
+ * pass each spectrum to callback. Returns the number of spectra passed, or
+ * -1 on failure.
+ */
+long audioviz_stream(audioviz_analyzer *analyzer, double rate,
+                     unsigned long first, unsigned long last,
+                     audioviz_spectrum_callback callback, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIOVIZ_H */
@@ -0,0 +1,128 @@
+#include <exception>
+#include <new>
+#include <string>
+
+#include "audioviz.h"
+#include "core.h"
+
+struct audioviz_track {
+    explicit audioviz_track(const char *filename) : track(filename) {}
+    audioviz::Track track;
+};
+
+struct audioviz_analyzer {
+    explicit audioviz_analyzer(const audioviz_track *track)
+        : analyzer(track->track) {}
+    audioviz::Analyzer analyzer;
+};
+
+static thread_local std::string last_error;
+
+// Run f, turning any exception into the thread's last error. No exception
+// may cross into C.
+template <typename F>
+static bool guard(F &&f) {
+    try {
+        f();
+        return true;
+    } catch (const std::bad_alloc &) {
+        last_error = "out of memory";
+    } catch (const std::exception &e) {
+        last_error = e.what();
+    } catch (...) {
+        last_error = "unknown error";
+    }
+    return false;
+}
+
+const char *audioviz_last_error(void) { return last_error.c_str(); }
+
+audioviz_track *audioviz_track_open(const char *filename) {
+    audioviz_track *track = nullptr;
+    if (!filename) {
+        last_error = "no filename";
+        return nullptr;
+    }
+    guard([&] { track = new audioviz_track(filename); });
+    return track;
+}
+
+void audioviz_track_close(audioviz_track *track) { delete track; }
+
+unsigned long audioviz_track_num_channels(const audioviz_track *track) {
+    return track->track.num_channels();
+}
+
+unsigned long audioviz_track_num_samples(const audioviz_track *track) {
+    return track->track.num_samples();
+}
+
+unsigned long audioviz_track_sample_rate(const audioviz_track *track) {
+    return track->track.sample_rate();
+}
+
+audioviz_analyzer *audioviz_analyzer_create(const audioviz_track *track) {
+    audioviz_analyzer *analyzer = nullptr;
+    if (!track) {
+        last_error = "no track";
+        return nullptr;
+    }
+    guard([&] { analyzer = new audioviz_analyzer(track); });
+    return analyzer;
+}
+
+void audioviz_analyzer_destroy(audioviz_analyzer *analyzer) {
+    delete analyzer;
+}
+
+unsigned long audioviz_analyzer_num_notes(const audioviz_analyzer *analyzer) {
+    return analyzer->analyzer.num_notes();
+}
+
+int audioviz_analyzer_min_note(const audioviz_analyzer *analyzer) {
+    return analyzer->analyzer.min_note();
+}
+
+int audioviz_analyzer_max_note(const audioviz_analyzer *analyzer) {
+    return analyzer->analyzer.max_note();
+}
+
+int audioviz_analyzer_set_rate(audioviz_analyzer *analyzer, double rate) {
+    if (!(rate >= 0)) {
+        last_error = "rate must not be negative";
+        return -1;
+    }
+    return guard([&] { analyzer->analyzer.set_rate(rate); }) ? 0 : -1;
+}
+
+int audioviz_analyse(audioviz_analyzer *analyzer, unsigned long position,
+                     const float **left, const float **right) {
+    return guard([&] {
+               const audioviz::Spectrum &spectrum =
+                   analyzer->analyzer.analyse(position);
+               *left = spectrum.left.data();
+               *right = spectrum.right.data();
+           })
+               ? 0
+               : -1;
+}
+
+long audioviz_stream(audioviz_analyzer *analyzer, double rate,
+                     unsigned long first, unsigned long last,
+                     audioviz_spectrum_callback callback, void *user_data) {
+    if (!(rate > 0) || !callback) {
+        last_error = "stream needs a positive rate and a callback";
+        return -1;
+    }
+    long count = 0;
+    const unsigned long num_notes = analyzer->analyzer.num_notes();
+    const bool ok = guard([&] {
+        count = analyzer->analyzer.stream(
+            rate, first, last, [&](const audioviz::Spectrum &spectrum) {
+                return callback(user_data, spectrum.position,
+                                spectrum.left.data(), spectrum.right.data(),
+                                num_notes) == 0;
+            });
+    });
+    return ok ? count : -1;
+}
@@ -0,0 +1,91 @@
+#include "core.h"
+
+#include <cmath>
+
+#include "algorithm/note_stft.h"
+#include "algorithm/spectrum_analyzer.h"
+#include "audio/file_source.h"
+
+namespace audioviz {
+
+struct Track::Impl {
+    FileAudioSource source;
+};
+
+Track::Track(const std::string &filename) : impl_(std::make_unique<Impl>()) {
+    try {
+        impl_->source.open(filename);
+    } catch (const AudioSourceError &e) {
+        throw Error(e.what());
+    }
+}
+
+Track::~Track() = default;
+
+unsigned long Track::num_channels() const {
+    return impl_->source.num_channels();
+}
+
+unsigned long Track::num_samples() const {
+    return impl_->source.num_samples();
+}
+
+unsigned long Track::sample_rate() const {
+    return impl_->source.sample_rate();
+}
+
+std::string Track::description() const {
+    return impl_->source.description();
+}
+
+struct Analyzer::Impl {
+    explicit Impl(const IAudioSource &source)
+        : sample_rate(source.sample_rate()),
+          stft(create_note_stft(sample_rate)),
+          analyzer(source, stft) {}
+
+    const unsigned long sample_rate;
+    const STFT stft;
+    SpectrumAnalyzer analyzer;
+    Spectrum spectrum;
+};
+
+Analyzer::Analyzer(const Track &track)
+    : impl_(std::make_unique<Impl>(track.impl_->source)) {}
+
+Analyzer::~Analyzer() = default;
+
+unsigned long Analyzer::num_notes() const { return impl_->stft.length(); }
+
+int Analyzer::min_note() const { return note_stft::min_note; }
+
+int Analyzer::max_note() const { return note_stft::max_note; }
+
+void Analyzer::set_rate(double rate) { impl_->analyzer.set_rate(rate); }
+
+const Spectrum &Analyzer::analyse(unsigned long position) {
+    impl_->analyzer.update(position);
+    impl_->spectrum.position = position;
+    impl_->spectrum.left = impl_->analyzer.left();
+    impl_->spectrum.right = impl_->analyzer.right();
+    return impl_->spectrum;
+}
+
+unsigned long Analyzer::stream(
+    double rate, unsigned long first, unsigned long last,
+    const std::function<bool(const Spectrum &)> &callback) {
+    if (rate <= 0 || first >= last) return 0;
+
+    // Frames on the grid of the rate, so streams of adjacent ranges line up
+    const double hop = impl_->sample_rate / rate;
+    unsigned long count = 0;
+    for (long frame = (long)std::ceil(first / hop);; frame++) {
+        const unsigned long position = std::llround(frame * hop);
+        if (position >= last) break;
+        count++;
+        if (!callback(analyse(position))) break;
+    }
+    return count;
+}
+
+}  // namespace audioviz
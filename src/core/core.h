@@ -0,0 +1,93 @@
+#ifndef AUDIOVIZ_CORE_H
+#define AUDIOVIZ_CORE_H
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Headless analysis library: decode a track and compute the note spectra the
+// visualizer shows, with no SDL, GL or display involved. Neither FFmpeg nor
+// libspectrogram headers are needed to use it. core/audioviz.h wraps the
+// same API for C.
+//
+//     audioviz::Track track("song.flac");
+//     audioviz::Analyzer analyzer(track);
+//     const audioviz::Spectrum &now = analyzer.analyse(position);
+//     analyzer.stream(60, 0, track.num_samples(),
+//                     [](const audioviz::Spectrum &spectrum) {
+//                         ...;
+//                         return true;
+//                     });
+namespace audioviz {
+
+class Error : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+};
+
+// Stereo note spectra centred on a sample position. Values are evenly spaced
+// from min_note to max_note semitones relative to A4.
+struct Spectrum {
+    unsigned long position = 0;
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+// A decoded audio file, held in memory as float samples
+class Track {
+   public:
+    // Throws Error if the file cannot be decoded
+    explicit Track(const std::string &filename);
+    ~Track();
+    Track(const Track &) = delete;
+    Track &operator=(const Track &) = delete;
+
+    // Files are decoded to stereo, whatever their own layout
+    unsigned long num_channels() const;
+    unsigned long num_samples() const;
+    unsigned long sample_rate() const;
+    std::string description() const;
+
+   private:
+    friend class Analyzer;
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Computes spectra of a track, which must outlive it. One thread at a time;
+// use one analyzer per thread to analyse in parallel.
+class Analyzer {
+   public:
+    explicit Analyzer(const Track &track);
+    ~Analyzer();
+    Analyzer(const Analyzer &) = delete;
+    Analyzer &operator=(const Analyzer &) = delete;
+
+    unsigned long num_notes() const;
+    int min_note() const;
+    int max_note() const;
+
+    // Analysis frames per second of audio, 0 analyses every call exactly.
+    // Otherwise positions between frames are interpolated.
+    void set_rate(double rate);
+
+    // Spectra at position, valid until the next call. All zero where the
+    // track has no full analysis window around it.
+    const Spectrum &analyse(unsigned long position);
+
+    // Analyse positions [first, last) at rate frames per second of audio and
+    // pass each spectrum to callback, which returns false to stop early.
+    // Returns the number of spectra passed.
+    unsigned long stream(double rate, unsigned long first, unsigned long last,
+                         const std::function<bool(const Spectrum &)> &callback);
+
+   private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace audioviz
+
+#endif /* AUDIOVIZ_CORE_H */
@@ -0,0 +1,102 @@
+#include "spectrum_publisher.h"
+
+#include <algorithm>  // copy_n, fill_n, min
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+static constexpr unsigned long num_channels = 2;
+
+static std::runtime_error shm_error(const std::string &what,
+                                    const std::string &name) {
+    return std::runtime_error(what + " " + name + ": " + strerror(errno));
+}
+
+SpectrumPublisher::SpectrumPublisher(const std::string &name,
+                                     unsigned long sample_rate,
+                                     unsigned long num_notes, int min_note,
+                                     int max_note, unsigned long num_slots)
+    : name_(name) {
+    static_assert(sizeof(audioviz_spectrum_header) == 64,
+                  "Header layout is part of the reader ABI");
+
+    // Whole cache lines per slot, so a writer never shares one with readers
+    // of the neighbouring slot
+    const size_t slot_bytes = sizeof(audioviz_spectrum_slot) +
+                              num_channels * num_notes * sizeof(float);
+    const size_t slot_size = (slot_bytes + 63) / 64 * 64;
+    size_ = sizeof(audioviz_spectrum_header) + num_slots * slot_size;
+
+    // Start from scratch, readers of a previous run keep their old mapping
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) throw shm_error("Could not create shared memory", name_);
+    if (ftruncate(fd, size_) != 0) {
+        close(fd);
+        shm_unlink(name_.c_str());
+        throw shm_error("Could not size shared memory", name_);
+    }
+    void *memory =
+        mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        throw shm_error("Could not map shared memory", name_);
+    }
+
+    // Fresh pages are zero, so every slot starts out even and empty.
+    // Readers load the magic first, so it is stored last.
+    header_ = (audioviz_spectrum_header *)memory;
+    header_->version = AUDIOVIZ_SPECTRUM_VERSION;
+    header_->num_slots = num_slots;
+    header_->slot_size = slot_size;
+    header_->num_channels = num_channels;
+    header_->num_notes = num_notes;
+    header_->min_note = min_note;
+    header_->max_note = max_note;
+    header_->sample_rate = sample_rate;
+    __atomic_store_n(&header_->magic, AUDIOVIZ_SPECTRUM_MAGIC,
+                     __ATOMIC_RELEASE);
+}
+
+SpectrumPublisher::~SpectrumPublisher() {
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+}
+
+audioviz_spectrum_slot *SpectrumPublisher::slot_at(uint64_t index) {
+    return (audioviz_spectrum_slot *)((char *)(header_ + 1) +
+                                      (index % header_->num_slots) *
+                                          header_->slot_size);
+}
+
+void SpectrumPublisher::publish(unsigned long sample_position,
+                                const std::vector<float> &left,
+                                const std::vector<float> &right) {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    audioviz_spectrum_slot *slot = slot_at(write_index_);
+    const uint64_t sequence = slot->sequence;
+
+    // Odd sequence: readers of this slot will find their copy invalid
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->index = write_index_;
+    slot->sample_position = sample_position;
+    slot->timestamp_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+
+    const size_t num_notes = header_->num_notes;
+    float *notes = (float *)(slot + 1);
+    for (const std::vector<float> *spectrum : {&left, &right}) {
+        const size_t count = std::min(num_notes, spectrum->size());
+        std::copy_n(spectrum->data(), count, notes);
+        std::fill_n(notes + count, num_notes - count, 0.0f);
+        notes += num_notes;
+    }
+
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&header_->write_index, ++write_index_, __ATOMIC_RELEASE);
+}
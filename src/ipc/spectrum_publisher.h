@@ -0,0 +1,35 @@
+#ifndef SPECTRUM_PUBLISHER_H
+#define SPECTRUM_PUBLISHER_H
+
+#include <string>
+#include <vector>
+
+#include "spectrum_shm.h"
+
+// Writer of the shared-memory spectrum ring described in spectrum_shm.h.
+// Creates the named POSIX shared-memory segment, replacing a stale one, and
+// unlinks it again when destroyed. Only one thread may publish.
+class SpectrumPublisher {
+   public:
+    SpectrumPublisher(const std::string &name, unsigned long sample_rate,
+                      unsigned long num_notes, int min_note, int max_note,
+                      unsigned long num_slots = 64);
+    ~SpectrumPublisher();
+    SpectrumPublisher(const SpectrumPublisher &) = delete;
+    SpectrumPublisher &operator=(const SpectrumPublisher &) = delete;
+
+    // Copy a stereo note spectrum into the next slot. Spectra of another
+    // length are cut or zero-padded to num_notes.
+    void publish(unsigned long sample_position, const std::vector<float> &left,
+                 const std::vector<float> &right);
+
+   private:
+    const std::string name_;
+    size_t size_;
+    audioviz_spectrum_header *header_;
+    uint64_t write_index_ = 0;
+
+    audioviz_spectrum_slot *slot_at(uint64_t index);
+};
+
+#endif /* SPECTRUM_PUBLISHER_H */
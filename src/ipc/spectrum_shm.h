@@ -0,0 +1,186 @@
+/*
+ * Reader side of the spectrum ring that audioviz publishes in POSIX shared
+ * memory (audioviz --publish <name>). Plain C99, header only, no audioviz
+ * code needed: include it and link with -lrt on older glibc. Strict ISO
+ * modes need _POSIX_C_SOURCE >= 200112L for shm_open, as usual.
+ *
+ * The segment starts with a header followed by num_slots fixed-size slots.
+ * Each analysed spectrum goes into the next slot round the ring. A slot is
+ * guarded by a sequence counter that is odd while the writer is inside it,
+ * so readers work on the shared memory directly and check afterwards that
+ * what they read was not being overwritten:
+ *
+ *     struct audioviz_spectrum_reader reader;
+ *     if (audioviz_spectrum_open("/audioviz", &reader) != 0) ...;
+ *
+ *     const struct audioviz_spectrum_slot *slot;
+ *     uint64_t sequence;
+ *     while ((slot = audioviz_spectrum_next(&reader, &sequence))) {
+ *         const float *left = audioviz_spectrum_notes(slot);
+ *         const float *right = left + reader.header->num_notes;
+ *         ... use left, right, slot->sample_position ...
+ *         if (!audioviz_spectrum_valid(slot, sequence)) ... discard ...;
+ *     }
+ *
+ *     audioviz_spectrum_close(&reader);
+ */
+
+#ifndef AUDIOVIZ_SPECTRUM_SHM_H
+#define AUDIOVIZ_SPECTRUM_SHM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define AUDIOVIZ_SPECTRUM_MAGIC 0x50535641u /* "AVSP" */
+#define AUDIOVIZ_SPECTRUM_VERSION 1u
+
+struct audioviz_spectrum_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_slots;
+    uint32_t slot_size;    /* Bytes from one slot to the next */
+    uint32_t num_channels; /* Spectra per slot, left then right */
+    uint32_t num_notes;    /* Values per spectrum */
+    int32_t min_note;      /* Semitones from A4 of the first value */
+    int32_t max_note;      /* and of the last, evenly spaced in between */
+    uint64_t sample_rate;
+    uint64_t write_index;  /* Spectra published so far */
+    uint8_t reserved[16];  /* Pads the header to 64 bytes */
+};
+
+struct audioviz_spectrum_slot {
+    uint64_t sequence;        /* Odd while being written */
+    uint64_t index;           /* Publication index of the contents */
+    uint64_t sample_position; /* Centre of the analysed audio */
+    int64_t timestamp_ns;     /* CLOCK_MONOTONIC at publication */
+    /* num_channels * num_notes floats follow */
+};
+
+struct audioviz_spectrum_reader {
+    const struct audioviz_spectrum_header *header;
+    size_t size;
+    uint64_t next_index; /* Next publication index to return */
+    uint64_t dropped;    /* Spectra overwritten before they were read */
+};
+
+static inline const struct audioviz_spectrum_slot *audioviz_spectrum_slot_at(
+    const struct audioviz_spectrum_header *header, uint64_t index) {
+    return (const struct audioviz_spectrum_slot
+                *)((const char *)(header + 1) +
+                   (size_t)(index % header->num_slots) * header->slot_size);
+}
+
+static inline const float *audioviz_spectrum_notes(
+    const struct audioviz_spectrum_slot *slot) {
+    return (const float *)(slot + 1);
+}
+
+/* Map the ring published under name. Returns 0, or -1 with errno set
+ * (EPROTO if the segment is not a compatible spectrum ring). Reading starts
+ * at the newest spectrum. */
+static inline int audioviz_spectrum_open(
+    const char *name, struct audioviz_spectrum_reader *reader) {
+    struct stat st;
+    void *memory;
+    const struct audioviz_spectrum_header *header;
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(struct audioviz_spectrum_header)) {
+        close(fd);
+        errno = EPROTO;
+        return -1;
+    }
+    memory = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return -1;
+
+    /* The writer stores the magic last, so once it is seen the rest of the
+     * header is complete */
+    header = (const struct audioviz_spectrum_header *)memory;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) !=
+            AUDIOVIZ_SPECTRUM_MAGIC ||
+        header->version != AUDIOVIZ_SPECTRUM_VERSION ||
+        header->num_slots == 0 ||
+        header->slot_size < sizeof(struct audioviz_spectrum_slot) +
+                                (size_t)header->num_channels *
+                                    header->num_notes * sizeof(float) ||
+        sizeof(*header) + (size_t)header->num_slots * header->slot_size >
+            (size_t)st.st_size) {
+        munmap(memory, (size_t)st.st_size);
+        errno = EPROTO;
+        return -1;
+    }
+
+    reader->header = header;
+    reader->size = (size_t)st.st_size;
+    reader->dropped = 0;
+    reader->next_index =
+        __atomic_load_n(&header->write_index, __ATOMIC_ACQUIRE);
+    if (reader->next_index > 0) reader->next_index--;
+    return 0;
+}
+
+static inline void audioviz_spectrum_close(
+    struct audioviz_spectrum_reader *reader) {
+    if (reader->header) munmap((void *)reader->header, reader->size);
+    reader->header = NULL;
+}
+
+/* The next unread spectrum in publication order, or NULL if the reader has
+ * caught up. The slot is read in place; sequence receives the value to pass
+ * to audioviz_spectrum_valid() once done with it. */
+static inline const struct audioviz_spectrum_slot *audioviz_spectrum_next(
+    struct audioviz_spectrum_reader *reader, uint64_t *sequence) {
+    const struct audioviz_spectrum_header *header = reader->header;
+    for (;;) {
+        const struct audioviz_spectrum_slot *slot;
+        const uint64_t written =
+            __atomic_load_n(&header->write_index, __ATOMIC_ACQUIRE);
+        if (reader->next_index >= written) return NULL;
+
+        /* The slot after the newest may already be in the writer's hands */
+        if (written - reader->next_index >= header->num_slots) {
+            const uint64_t oldest = written - header->num_slots + 1;
+            reader->dropped += oldest - reader->next_index;
+            reader->next_index = oldest;
+        }
+
+        slot = audioviz_spectrum_slot_at(header, reader->next_index);
+        *sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if ((*sequence & 1) == 0 && slot->index == reader->next_index) {
+            reader->next_index++;
+            return slot;
+        }
+
+        /* Overwritten since write_index was read, try the next one */
+        reader->dropped++;
+        reader->next_index++;
+    }
+}
+
+/* Skip everything but the newest spectrum */
+static inline void audioviz_spectrum_skip_to_latest(
+    struct audioviz_spectrum_reader *reader) {
+    const uint64_t written =
+        __atomic_load_n(&reader->header->write_index, __ATOMIC_ACQUIRE);
+    if (written > reader->next_index + 1) reader->next_index = written - 1;
+}
+
+/* Nonzero if the slot was not touched by the writer since
+ * audioviz_spectrum_next() returned it, i.e. everything read from it in
+ * between is consistent. */
+static inline int audioviz_spectrum_valid(
+    const struct audioviz_spectrum_slot *slot, uint64_t sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+#endif /* AUDIOVIZ_SPECTRUM_SHM_H */
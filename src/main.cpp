@@ -1,31 +1,181 @@
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <vector>
 
+#include "algorithm/kernels.h"
+#include "algorithm/note_stft.h"
 #include "algorithm/stft.h"
 #include "audio/file_source.h"
 #include "audio/player.h"
+#include "ipc/spectrum_publisher.h"
+#include "store/spectra_file.h"
 #include "video/framebuffer.h"
+#include "video/gl_state.h"
+#include "video/offline_renderer.h"
+#include "video/render_benchmark.h"
 #include "video/shader_program.h"
 #include "video/window.h"
 #include "visuals/eclipse/eclipse.h"
 #include "visuals/liquid/liquid.h"
+#include "visuals/scope/scope.h"
+#include "visuals/waterfall/waterfall.h"
 
 using namespace std;
 
+static void print_usage() {
+    fprintf(stderr,
+            "Usage: audioviz [options] <audio file>\n"
+            "       audioviz --check-kernels\n"
+            "       audioviz --bench-render [--size <w>x<h>,...] "
+            "[--frames <n>]\n"
+            "                [--dump <dir>] [--golden <dir>]\n\n"
+            "Options:\n"
+            "  --export <video file>  Render to a video file and exit\n"
+            "  --fps <rate>           Export frame rate (default 60)\n"
+            "  --size <w>x<h>         Export resolution (default 1920x1080)\n"
+            "  --no-msaa              Export without multisampling\n"
+            "  --no-bloom             Export without bloom\n"
+            "  --threads <count>      Export workers (default one per core)\n"
+            "  --visual <name>        eclipse (default), liquid, scope or "
+            "waterfall\n"
+            "  --span <seconds>       Audio across the scope (default 0.05)\n"
+            "  --history <frames>     Spectra in the waterfall (default 512)\n"
+            "  --profile              Report GPU time per render pass\n"
+            "  --analysis-rate <hz>   Analyse audio at this fixed rate and "
+            "interpolate\n"
+            "                         spectra in between (default: every "
+            "frame)\n"
+            "  --render-scale <s>     Render at this share of the window "
+            "size (0.25-1)\n"
+            "  --frame-budget <ms>    Pick the render scale to keep GPU "
+            "frame time within\n"
+            "  --publish <name>       Share spectra in POSIX shared memory "
+            "<name>\n"
+            "  --spectra <file>       Play spectra precomputed by "
+            "audioviz-analyze\n"
+            "  --idle-fps <rate>      Wake-ups per second while nothing "
+            "changes\n"
+            "                         (default 10)\n\n"
+            "Render benchmark, headless with a synthetic signal:\n"
+            "  --bench-render         Time every visual, MSAA and bloom setup\n"
+            "  --size <w>x<h>,...     Resolutions to render "
+            "(default 640x360,1280x720,1920x1080)\n"
+            "  --frames <n>           Timed frames per case (default 60)\n"
+            "  --dump <dir>           Save the last frame of each case as PNG\n"
+            "  --golden <dir>         Compare frames against PNGs in <dir>\n");
+}
+
 int main(int argc, char** argv) {
-    if (argc < 2) {
+    const char* filename = nullptr;
+    RenderSettings export_settings;
+    RenderBenchSettings bench_settings;
+    bool bench_render = false;
+    bool profile = false;
+    double analysis_rate = 0;
+    double idle_fps = 10;
+    float render_scale = 1;
+    float frame_budget = 0;
+    const char* publish_name = nullptr;
+    const char* spectra_filename = nullptr;
+    std::string visual_name = "eclipse";
+    double scope_span = 0.05;
+    int waterfall_history = 512;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--check-kernels") {
+            // Check the CPU-specific DSP kernels against the scalar reference
+            std::string report;
+            const bool ok = kernels::verify(report);
+            std::cout << report;
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (arg == "--export" && has_value) {
+            export_settings.output = argv[++i];
+        } else if (arg == "--fps" && has_value) {
+            export_settings.fps = atoi(argv[++i]);
+        } else if (arg == "--size" && has_value) {
+            const char* sizes = argv[++i];
+            sscanf(sizes, "%dx%d", &export_settings.width,
+                   &export_settings.height);
+
+            // The render benchmark takes a comma separated list
+            bench_settings.sizes.clear();
+            for (const char* size = sizes; size; size = strchr(size, ',')) {
+                if (*size == ',') size++;
+                int width, height;
+                if (sscanf(size, "%dx%d", &width, &height) == 2 &&
+                    width > 0 && height > 0)
+                    bench_settings.sizes.emplace_back(width, height);
+            }
+        } else if (arg == "--threads" && has_value) {
+            export_settings.threads = atoi(argv[++i]);
+        } else if (arg == "--no-msaa") {
+            export_settings.msaa = false;
+        } else if (arg == "--no-bloom") {
+            export_settings.bloom = false;
+        } else if (arg == "--visual" && has_value) {
+            visual_name = argv[++i];
+        } else if (arg == "--span" && has_value) {
+            scope_span = atof(argv[++i]);
+        } else if (arg == "--history" && has_value) {
+            waterfall_history = atoi(argv[++i]);
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--analysis-rate" && has_value) {
+            analysis_rate = atof(argv[++i]);
+        } else if (arg == "--render-scale" && has_value) {
+            render_scale = atof(argv[++i]);
+        } else if (arg == "--frame-budget" && has_value) {
+            frame_budget = atof(argv[++i]);
+        } else if (arg == "--publish" && has_value) {
+            publish_name = argv[++i];
+        } else if (arg == "--spectra" && has_value) {
+            spectra_filename = argv[++i];
+        } else if (arg == "--idle-fps" && has_value) {
+            idle_fps = std::max(0.1, atof(argv[++i]));
+        } else if (arg == "--bench-render") {
+            bench_render = true;
+        } else if (arg == "--frames" && has_value) {
+            bench_settings.frames = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--dump" && has_value) {
+            bench_settings.dump_dir = argv[++i];
+        } else if (arg == "--golden" && has_value) {
+            bench_settings.golden_dir = argv[++i];
+        } else if (arg[0] == '-') {
+            print_usage();
+            return EXIT_FAILURE;
+        } else {
+            filename = argv[i];
+        }
+    }
+
+    // Headless render benchmark, needs no audio file, window or display
+    if (bench_render) {
+        try {
+            return render_benchmark(bench_settings) ? EXIT_SUCCESS
+                                                    : EXIT_FAILURE;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (filename == nullptr) {
         fprintf(stderr, "Please supply a filename to a music file.\n");
+        print_usage();
         return EXIT_FAILURE;
     }
 
     // Load audio file
     FileAudioSource audio_source;
     try {
-        audio_source.open(argv[1]);
+        audio_source.open(filename);
     } catch (const AudioSourceError& e) {
         std::cerr << "Error loading audio source:" << std::endl;
         std::cerr << e.what() << std::endl;
@@ -33,6 +183,24 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    // Offline export, no window or audio device needed
+    if (!export_settings.output.empty()) {
+        // Encoders working in 4:2:0 need even dimensions
+        export_settings.width = std::max(2, export_settings.width & ~1);
+        export_settings.height = std::max(2, export_settings.height & ~1);
+        export_settings.fps = std::max(1, export_settings.fps);
+
+        std::cout << "Exporting " << audio_source.description() << " to "
+                  << export_settings.output << std::endl;
+        try {
+            render_offline(audio_source, export_settings);
+        } catch (const std::exception& e) {
+            std::cerr << std::endl << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     AudioPlayer audio_player = AudioPlayer(audio_source);
 
     if (!audio_player.playable() || audio_source.num_samples() == 0) {
@@ -41,23 +209,91 @@ int main(int argc, char** argv) {
     }
 
     std::cout << "Playing " << audio_source.description() << std::endl;
+    std::cout << "DSP kernels: " << kernels::active().name << std::endl;
 
     // Initialize window and context
     Window window;
 
-    // Create a framebuffer
+    // Create a framebuffer, rendering at a fixed or adaptive scale of the
+    // window size
     FrameBuffer fb(window.width(), window.height(), true);
+    if (frame_budget > 0) {
+        fb.set_frame_budget(frame_budget);
+    } else {
+        fb.set_render_scale(render_scale);
+    }
 
     // Setup visual effect renderer
-    EclipseVisual visual(audio_source, fb);
+    std::unique_ptr<IVisual> visual;
+    if (visual_name == "liquid") {
+        visual = std::make_unique<LiquidVisual>(audio_source, fb);
+    } else if (visual_name == "scope") {
+        auto scope = std::make_unique<ScopeVisual>(audio_source, fb);
+        scope->set_span(scope_span);
+        visual = std::move(scope);
+    } else if (visual_name == "waterfall") {
+        auto waterfall = std::make_unique<WaterfallVisual>(audio_source, fb);
+        waterfall->set_history(waterfall_history);
+        visual = std::move(waterfall);
+    } else {
+        visual = std::make_unique<EclipseVisual>(audio_source, fb);
+    }
+
+    // Decouple spectrum analysis from the display refresh rate
+    visual->set_analysis_rate(analysis_rate);
+
+    // Publish the spectra for other local processes, see ipc/spectrum_shm.h
+    std::unique_ptr<SpectrumPublisher> publisher;
+    if (publish_name) {
+        const SharedParams& params = fb.shared_params();
+        try {
+            publisher = std::make_unique<SpectrumPublisher>(
+                publish_name, audio_source.sample_rate(), params.num_freq,
+                params.min_note, params.max_note);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        visual->set_spectrum_publisher(publisher.get());
+    }
+
+    // Read the spectra from disk instead of analysing them live
+    std::unique_ptr<SpectraFile> spectra;
+    if (spectra_filename) {
+        const SharedParams& params = fb.shared_params();
+        try {
+            spectra = std::make_unique<SpectraFile>(spectra_filename);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        const SpectraFileHeader& header = spectra->header();
+        if (header.sample_rate != audio_source.sample_rate() ||
+            header.window_length != note_stft::window_length ||
+            header.transform_length != note_stft::transform_length ||
+            header.window_type != (uint32_t)note_stft::window_type ||
+            (int)header.num_notes != params.num_freq ||
+            header.min_note != params.min_note ||
+            header.max_note != params.max_note) {
+            std::cerr << spectra_filename << " was not analysed from "
+                      << filename << " with this configuration" << std::endl;
+            return EXIT_FAILURE;
+        }
+        visual->set_precomputed_spectra(spectra.get());
+    }
+
+    // Optional per-pass GPU timing
+    GpuProfiler profiler;
+    GpuProfiler* const frame_profiler = profile ? &profiler : nullptr;
+    fb.set_profiler(frame_profiler);
 
     // Enable v-sync
     SDL_GL_SetSwapInterval(1);
 
     // Disable depth, enable alpha blending
     glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
+    gl_state::set_blend(true);
+    gl_state::blend_func(GL_ONE, GL_ONE);
     glDepthMask(false);
 
     // Check for GL errors
@@ -71,11 +307,22 @@ int main(int argc, char** argv) {
     unsigned long frame_count = 0;
     bool force_refresh = true;
 
+    // Only redraw when something visible changed, the window keeps showing
+    // the last presented frame otherwise
+    bool dirty = true;
+    bool idle = false;
+    long drawn_sample = -1;
+    const int idle_timeout = std::max(1, (int)(1000 / idle_fps));
+
     // Render Loop
     bool quit = false;
     while (!quit) {
         SDL_Event e;
 
+        // Nothing changed last time: sleep until an event instead of spinning,
+        // v-sync no longer paces a loop that does not swap
+        if (idle) SDL_WaitEventTimeout(nullptr, idle_timeout);
+
         while (SDL_PollEvent(&e)) {
             switch (e.type) {
                 case SDL_QUIT:
@@ -83,15 +330,17 @@ int main(int argc, char** argv) {
                     break;
 
                 case SDL_WINDOWEVENT:
+                    // Exposed, resized, restored and so on
+                    dirty = true;
                     if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-                        const int width = e.window.data1;
-                        const int height = e.window.data2;
-                        fb.set_resolution(width, height);
-                        visual.set_resolution(width, height);
+                        // Applied once the window has settled
+                        fb.request_resolution(e.window.data1,
+                                              e.window.data2);
                     }
                     break;
 
                 case SDL_KEYDOWN:
+                    dirty = true;
                     switch (e.key.keysym.sym) {
                         case SDLK_SPACE:
                             audio_player.toggle_playback();
@@ -131,9 +380,29 @@ int main(int argc, char** argv) {
             }
         }
 
-        // Render visual effects for current position into framebuffer
+        // Reallocate render targets after a resize or a new render scale
+        if (fb.update_resolution()) {
+            visual->set_resolution(fb.width(), fb.height());
+            dirty = true;
+        }
+
+        // Skip analysis and rendering while paused with nothing to update,
+        // keep drawing until a pending resize has settled
         long current_sample = audio_player.current_sample();
-        visual.draw(current_sample);
+        if (current_sample != drawn_sample || fb.resize_pending())
+            dirty = true;
+        idle = !dirty;
+        if (idle) continue;
+        dirty = false;
+        drawn_sample = current_sample;
+
+        if (profile) profiler.begin_frame();
+
+        // Render visual effects for current position into framebuffer
+        {
+            GpuProfiler::Scope timer(frame_profiler, "visual");
+            visual->draw(current_sample);
+        }
 
         // Draw framebuffer to screen
         fb.draw();
@@ -149,6 +418,9 @@ int main(int argc, char** argv) {
             if ((current_time - start_time) >= 2 || force_refresh) {
                 printf("\r%s (fps: %4.4f)", current_time_str.c_str(),
                        frame_count / (current_time - start_time));
+                if (profile)
+                    printf("\n  GPU ms (p50/p95): %s\n",
+                           profiler.report().c_str());
                 fflush(stdout);
                 frame_count = 0;
                 start_time = current_time;
@@ -0,0 +1,231 @@
+#include "spectra_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>  // fill, max, min
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+static_assert(sizeof(SpectraFileHeader) == 128,
+              "Header layout is part of the file format");
+static_assert(sizeof(SpectraBlockEntry) == 24,
+              "Index layout is part of the file format");
+
+static constexpr uint64_t page_size = 4096;
+
+// Quieter values within a block are clamped to this far below its loudest
+static constexpr float dynamic_range_db = 120;
+
+// log2(10) / 10, turns decibels into a power of two
+static constexpr float db_to_log2 = 0.33219280948873623f;
+
+static std::runtime_error file_error(const std::string &what,
+                                     const std::string &filename) {
+    return std::runtime_error(what + " " + filename + ": " + strerror(errno));
+}
+
+static uint64_t round_up(uint64_t value, uint64_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static bool write_all(int fd, const void *data, size_t size, uint64_t offset) {
+    return pwrite(fd, data, size, offset) == (ssize_t)size;
+}
+
+SpectraWriter::SpectraWriter(const std::string &filename,
+                             const SpectraFileHeader &header)
+    : filename_(filename), header_(header) {
+    if (header_.value_size != 2) header_.value_size = 1;
+    if (header_.frames_per_block == 0) header_.frames_per_block = 256;
+    if (header_.num_channels == 0 || header_.num_notes == 0)
+        throw std::runtime_error("No spectra to write to " + filename_);
+
+    std::memset(header_.magic, 0, sizeof(header_.magic));
+    std::memset(header_.reserved, 0, sizeof(header_.reserved));
+    header_.version = spectra_file_version;
+    header_.header_size = sizeof(SpectraFileHeader);
+    header_.num_blocks = (header_.num_frames + header_.frames_per_block - 1) /
+                         header_.frames_per_block;
+    header_.index_offset = sizeof(SpectraFileHeader);
+
+    block_stride_ = round_up((uint64_t)header_.frames_per_block *
+                                 header_.num_channels * header_.num_notes *
+                                 header_.value_size,
+                             page_size);
+    data_offset_ = round_up(header_.index_offset +
+                                header_.num_blocks * sizeof(SpectraBlockEntry),
+                            page_size);
+
+    fd_ = open(filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw file_error("Could not create", filename_);
+
+    // Every block gets its place up front, so they can be written in any
+    // order. The header stays zero until finish().
+    if (ftruncate(fd_, data_offset_ + header_.num_blocks * block_stride_) !=
+        0) {
+        close(fd_);
+        fd_ = -1;
+        throw file_error("Could not size", filename_);
+    }
+}
+
+SpectraWriter::~SpectraWriter() {
+    if (fd_ >= 0) close(fd_);
+}
+
+void SpectraWriter::write_block(unsigned long block, const float *frames) {
+    if (block >= header_.num_blocks)
+        throw std::runtime_error("Block out of range for " + filename_);
+
+    SpectraBlockEntry entry = {};
+    entry.offset = data_offset_ + block * block_stride_;
+    const uint64_t first = (uint64_t)block * header_.frames_per_block;
+    entry.num_frames = std::min<uint64_t>(header_.frames_per_block,
+                                          header_.num_frames - first);
+    const size_t num_values =
+        (size_t)entry.num_frames * header_.num_channels * header_.num_notes;
+
+    // Scale the block to its own loudest value
+    float max_db = -INFINITY;
+    float min_db = INFINITY;
+    for (size_t idx = 0; idx < num_values; idx++) {
+        if (frames[idx] <= 0) continue;
+        const float db = 10 * std::log10(frames[idx]);
+        max_db = std::max(max_db, db);
+        min_db = std::min(min_db, db);
+    }
+    const unsigned long levels = header_.value_size == 1 ? 255 : 65535;
+    if (max_db > -INFINITY) {
+        min_db = std::max(min_db, max_db - dynamic_range_db);
+        entry.min_db = min_db;
+        entry.step_db = (max_db - min_db) / (levels - 1);
+    }
+
+    std::vector<uint8_t> values(num_values * header_.value_size);
+    for (size_t idx = 0; idx < num_values; idx++) {
+        unsigned long q = 0;
+        if (frames[idx] > 0) {
+            const float db = 10 * std::log10(frames[idx]);
+            q = 1;
+            if (entry.step_db > 0)
+                q += std::lround(std::max(0.0f, db - entry.min_db) /
+                                 entry.step_db);
+            q = std::min(q, levels);
+        }
+        if (header_.value_size == 1) {
+            values[idx] = q;
+        } else {
+            values[2 * idx] = q;
+            values[2 * idx + 1] = q >> 8;
+        }
+    }
+
+    if (!write_all(fd_, values.data(), values.size(), entry.offset) ||
+        !write_all(fd_, &entry, sizeof(entry),
+                   header_.index_offset + block * sizeof(entry)))
+        throw file_error("Could not write", filename_);
+}
+
+void SpectraWriter::finish() {
+    std::memcpy(header_.magic, spectra_file_magic, sizeof(header_.magic));
+    const bool written = write_all(fd_, &header_, sizeof(header_), 0);
+    const bool closed = close(fd_) == 0;
+    fd_ = -1;
+    if (!written || !closed) throw file_error("Could not write", filename_);
+}
+
+SpectraFile::SpectraFile(const std::string &filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw file_error("Could not open", filename);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw file_error("Could not open", filename);
+    }
+    size_ = st.st_size;
+    if (size_ < sizeof(SpectraFileHeader)) {
+        close(fd);
+        throw std::runtime_error(filename + " is not a spectra file");
+    }
+    void *memory = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) throw file_error("Could not map", filename);
+    header_ = (const SpectraFileHeader *)memory;
+    index_ = (const SpectraBlockEntry *)((const char *)memory +
+                                         header_->index_offset);
+
+    // Validate everything read() relies on once, up front
+    bool valid = std::memcmp(header_->magic, spectra_file_magic,
+                             sizeof(header_->magic)) == 0 &&
+                 header_->version == spectra_file_version &&
+                 header_->header_size == sizeof(SpectraFileHeader) &&
+                 (header_->value_size == 1 || header_->value_size == 2) &&
+                 header_->num_channels > 0 && header_->num_notes > 0 &&
+                 header_->hop > 0 && header_->frames_per_block > 0 &&
+                 header_->num_blocks ==
+                     (header_->num_frames + header_->frames_per_block - 1) /
+                         header_->frames_per_block &&
+                 header_->index_offset <= size_ &&
+                 header_->num_blocks <=
+                     (size_ - header_->index_offset) /
+                         sizeof(SpectraBlockEntry);
+    const uint64_t frame_size = (uint64_t)header_->num_channels *
+                                header_->num_notes * header_->value_size;
+    for (uint32_t block = 0; valid && block < header_->num_blocks; block++) {
+        const SpectraBlockEntry &entry = index_[block];
+        valid = entry.num_frames <= header_->frames_per_block &&
+                entry.offset <= size_ &&
+                entry.num_frames * frame_size <= size_ - entry.offset;
+    }
+    if (!valid) {
+        munmap(memory, size_);
+        throw std::runtime_error(filename +
+                                 " is not a compatible spectra file");
+    }
+}
+
+SpectraFile::~SpectraFile() { munmap((void *)header_, size_); }
+
+void SpectraFile::dequantise(const SpectraBlockEntry &entry,
+                             const uint8_t *values,
+                             std::vector<float> &out) const {
+    const unsigned long num_notes = header_->num_notes;
+    out.resize(num_notes);
+    for (unsigned long idx = 0; idx < num_notes; idx++) {
+        const unsigned long q =
+            header_->value_size == 1
+                ? values[idx]
+                : values[2 * idx] | values[2 * idx + 1] << 8;
+        const float db = entry.min_db + (q - 1) * entry.step_db;
+        out[idx] = q == 0 ? 0.0f : std::exp2(db * db_to_log2);
+    }
+}
+
+void SpectraFile::read(long frame, std::vector<float> &left,
+                       std::vector<float> &right) const {
+    const unsigned long num_notes = header_->num_notes;
+    const long block = frame / (long)header_->frames_per_block;
+    const long offset = frame % (long)header_->frames_per_block;
+    if (frame < 0 || block >= (long)header_->num_blocks ||
+        offset >= index_[block].num_frames) {
+        left.assign(num_notes, 0.0f);
+        right.assign(num_notes, 0.0f);
+        return;
+    }
+
+    const SpectraBlockEntry &entry = index_[block];
+    const size_t spectrum_size = num_notes * header_->value_size;
+    const uint8_t *values = (const uint8_t *)header_ + entry.offset +
+                            offset * header_->num_channels * spectrum_size;
+    dequantise(entry, values, left);
+    if (header_->num_channels > 1) {
+        dequantise(entry, values + spectrum_size, right);
+    } else {
+        right = left;
+    }
+}
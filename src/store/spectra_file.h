@@ -0,0 +1,115 @@
+#ifndef SPECTRA_FILE_H
+#define SPECTRA_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Precomputed note spectra of one track, as written by audioviz-analyze.
+//
+//   SpectraFileHeader            128 bytes, little-endian
+//   SpectraBlockEntry[blocks]    at index_offset
+//   blocks                       at each entry's offset, page aligned
+//
+// Frame k holds the spectra centred on sample k * hop. Frames are grouped in
+// blocks of frames_per_block, each stored as
+// value[frames][num_channels][num_notes] of value_size bytes. Values are
+// power in decibels, quantised linearly per block: 0 is silence and q > 0 is
+// min_db + (q - 1) * step_db. Per-block scaling keeps quiet passages from
+// losing their resolution to loud ones elsewhere in the track.
+static constexpr char spectra_file_magic[8] = {'A', 'V', 'S', 'P',
+                                               'E', 'C', 'T', 'R'};
+static constexpr uint32_t spectra_file_version = 1;
+
+struct SpectraFileHeader {
+    char magic[8];  // Written last, so unfinished files are rejected
+    uint32_t version;
+    uint32_t header_size;
+
+    // Analysis configuration
+    uint64_t sample_rate;
+    uint32_t window_length;
+    uint32_t transform_length;
+    uint32_t window_type;   // enum window_type of libspectrogram
+    uint32_t num_channels;  // Left, then right
+    uint32_t num_notes;     // Values per spectrum
+    int32_t min_note;       // Semitones from A4 of the first value
+    int32_t max_note;       // and of the last, evenly spaced in between
+    uint32_t value_size;    // Bytes per value, 1 or 2
+    double hop;             // Samples between frames
+    uint64_t num_frames;
+
+    // Layout
+    uint32_t frames_per_block;
+    uint32_t num_blocks;
+    uint64_t index_offset;
+    uint8_t reserved[40];  // Pads the header to 128 bytes
+};
+
+struct SpectraBlockEntry {
+    uint64_t offset;  // From the start of the file
+    uint32_t num_frames;
+    float min_db;
+    float step_db;
+    uint32_t reserved;
+};
+
+// Writes a spectra file, one block at a time. Blocks may be written in any
+// order and from several threads at once.
+class SpectraWriter {
+   public:
+    // Fill in the analysis configuration, num_frames and optionally
+    // value_size and frames_per_block of header; the rest is computed
+    SpectraWriter(const std::string &filename, const SpectraFileHeader &header);
+    ~SpectraWriter();
+    SpectraWriter(const SpectraWriter &) = delete;
+    SpectraWriter &operator=(const SpectraWriter &) = delete;
+
+    const SpectraFileHeader &header() const { return header_; }
+
+    // Quantise and write a block of linear power spectra, laid out as
+    // float[frames][num_channels][num_notes]. Every block has
+    // frames_per_block frames except the last, which has the remainder.
+    void write_block(unsigned long block, const float *frames);
+
+    // Write the header and close the file
+    void finish();
+
+   private:
+    const std::string filename_;
+    SpectraFileHeader header_;
+    uint64_t data_offset_;   // First block
+    uint64_t block_stride_;  // Bytes from one block to the next
+    int fd_;
+};
+
+// Read-only memory mapping of a spectra file. Only the pages of the frames
+// that are read are ever loaded, and they stay in the page cache shared with
+// other processes instead of the heap.
+class SpectraFile {
+   public:
+    explicit SpectraFile(const std::string &filename);
+    ~SpectraFile();
+    SpectraFile(const SpectraFile &) = delete;
+    SpectraFile &operator=(const SpectraFile &) = delete;
+
+    const SpectraFileHeader &header() const { return *header_; }
+    double hop() const { return header_->hop; }
+    unsigned long num_frames() const { return header_->num_frames; }
+    unsigned long num_notes() const { return header_->num_notes; }
+
+    // Linear power spectra of frame, all zero outside the file. A mono file
+    // gives the same spectrum on both sides.
+    void read(long frame, std::vector<float> &left,
+              std::vector<float> &right) const;
+
+   private:
+    const SpectraFileHeader *header_;
+    const SpectraBlockEntry *index_;
+    size_t size_;
+
+    void dequantise(const SpectraBlockEntry &entry, const uint8_t *values,
+                    std::vector<float> &out) const;
+};
+
+#endif /* SPECTRA_FILE_H */
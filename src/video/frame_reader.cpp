@@ -0,0 +1,59 @@
+#include "frame_reader.h"
+
+#include "gl_state.h"
+
+FrameReader::FrameReader(const int width, const int height)
+    : width_(width), height_(height) {
+    glGenBuffers(2, pbo_);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, 4 * width_ * height_, NULL,
+                     GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameReader::~FrameReader() {
+    unmap();
+    glDeleteBuffers(2, pbo_);
+}
+
+const unsigned char *FrameReader::read(GLuint framebuffer) {
+    unmap();
+
+    // Queue the copy; with a pack buffer bound this returns immediately
+    gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[next_]);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    const bool had_pending = pending_;
+    next_ = 1 - next_;
+    pending_ = true;
+
+    return had_pending ? map(pbo_[next_]) : nullptr;
+}
+
+const unsigned char *FrameReader::finish() {
+    unmap();
+    if (!pending_) return nullptr;
+    pending_ = false;
+    next_ = 1 - next_;
+    return map(pbo_[next_]);
+}
+
+const unsigned char *FrameReader::map(GLuint pbo) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mapped_ = true;
+    return (const unsigned char *)pixels;
+}
+
+void FrameReader::unmap() {
+    // The mapped buffer is always the one the next read would go into
+    if (!mapped_) return;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[next_]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mapped_ = false;
+}
@@ -0,0 +1,38 @@
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include <GL/glew.h>
+
+// Asynchronous RGBA readback through a pair of pixel buffer objects. Each
+// read() queues a copy of the framebuffer and hands back the frame queued by
+// the previous call, so the GPU copy overlaps with rendering the next frame.
+class FrameReader {
+   public:
+    FrameReader(const int width, const int height);
+    ~FrameReader();
+    FrameReader(const FrameReader &) = delete;
+    FrameReader &operator=(const FrameReader &) = delete;
+
+    // Queue a read of the framebuffer and return the previous frame's pixels
+    // (bottom-up rows, valid until the next call), or nullptr on the first
+    const unsigned char *read(GLuint framebuffer);
+
+    // Return the last queued frame, or nullptr if there is none
+    const unsigned char *finish();
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+   private:
+    const int width_;
+    const int height_;
+    GLuint pbo_[2];
+    int next_ = 0;          // PBO that receives the next read
+    bool pending_ = false;  // Whether the other PBO holds an unread frame
+    bool mapped_ = false;   // Whether the other PBO is currently mapped
+
+    const unsigned char *map(GLuint pbo);
+    void unmap();
+};
+
+#endif /* FRAME_READER_H */
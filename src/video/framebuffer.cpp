@@ -1,30 +1,52 @@
 #include "framebuffer.h"
 
+#include <algorithm>  // max, min
+#include <cmath>
+
+#include "gl_state.h"
+
 const char *src_copy_vert =
 #include "shaders/copy_vert.glsl"
     ;
 const char *src_copy_frag_noMSAA =
 #include "shaders/copy_frag_noMSAA.glsl"
     ;
-const char *src_blurh_frag_noMSAA =
-#include "shaders/blurh_frag_noMSAA.glsl"
-    ;
-const char *src_blurv_frag_noMSAA =
-#include "shaders/blurv_frag_noMSAA.glsl"
-    ;
 
 const char *src_copy_frag_MSAA =
 #include "shaders/copy_frag_MSAA.glsl"
     ;
-const char *src_blurh_frag_MSAA =
-#include "shaders/blurh_frag_MSAA.glsl"
+const char *src_bloom_prefilter_frag =
+#include "shaders/bloom_prefilter_frag.glsl"
     ;
-const char *src_blurv_frag_MSAA =
-#include "shaders/blurv_frag_MSAA.glsl"
+const char *src_bloom_down_frag =
+#include "shaders/bloom_down_frag.glsl"
     ;
+const char *src_bloom_up_frag =
+#include "shaders/bloom_up_frag.glsl"
+    ;
+const char *src_bloom_composite_frag =
+#include "shaders/bloom_composite_frag.glsl"
+    ;
+
+// Share of each upsampled level kept when adding it to the level above, and
+// weight of the final glow on top of the scene
+static constexpr float bloom_spread = 0.6f;
+static constexpr float bloom_intensity = 0.8f;
+
+// Time without further resize requests before the targets are reallocated
+static constexpr std::chrono::milliseconds resize_settle(150);
+
+// Smallest fixed render scale, below this the image is mostly blur
+static constexpr float min_render_scale = 0.25f;
 
 FrameBuffer::FrameBuffer(const int width, const int height, bool do_msaa)
-    : width_(width), height_(height), do_msaa(do_msaa) {
+    : width_(width),
+      height_(height),
+      do_msaa(do_msaa),
+      output_width_(width),
+      output_height_(height) {
+    shared_params().resolution[0] = (float)width_;
+    shared_params().resolution[1] = (float)height_;
     init();
 }
 
@@ -33,137 +55,236 @@ FrameBuffer::~FrameBuffer() { deinit(); }
 void FrameBuffer::init() {
     if (do_msaa) {  // MSAA
 
-        num_samples = 5;
-        GL_TEXTURE_TYPE = GL_TEXTURE_2D_MULTISAMPLE;
+        // Software rasterizers such as llvmpipe cap the sample count at 4
+        GLint max_samples = 0;
+        glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &max_samples);
+        num_samples = std::min(5, (int)max_samples);
+
+        // Multisampled scene plus its single-sample resolve
+        num_buffers = 2;
+        resolved = 1;
 
         // Setup copy shader
         copy_shader.compile(src_copy_vert, src_copy_frag_MSAA);
         copy_shader.set_uniform("num_samples", num_samples);
-
-        // Setup horizontal and vertical blur shaders
-        hblur_shader.compile(src_copy_vert, src_blurh_frag_MSAA);
-        hblur_shader.set_uniform("num_samples", num_samples);
-
-        vblur_shader.compile(src_copy_vert, src_blurv_frag_MSAA);
-        vblur_shader.set_uniform("num_samples", num_samples);
     } else {  // No MSAA
 
         num_samples = 1;
-        GL_TEXTURE_TYPE = GL_TEXTURE_2D;
+
+        // The scene is post-processed directly
+        num_buffers = 1;
+        resolved = 0;
 
         // Setup copy shader
         copy_shader.compile(src_copy_vert, src_copy_frag_noMSAA);
-
-        // Setup horizontal and vertical blur shaders
-        hblur_shader.compile(src_copy_vert, src_blurh_frag_noMSAA);
-        vblur_shader.compile(src_copy_vert, src_blurv_frag_noMSAA);
     }
 
-    GLenum status;
-
-    // Create 2 textures and framebuffers
-    for (int i = 0; i < num_buffers; i++) {
-        // Create a FrameBuffer
-        glGenFramebuffers(1, &buffer[i]);
-        glBindFramebuffer(GL_FRAMEBUFFER, buffer[i]);
-
-        // Create the texture
-        glGenTextures(1, &texture[i]);
-        glBindTexture(GL_TEXTURE_TYPE, texture[i]);
-        if (num_samples > 1) {
-            glTexStorage2DMultisample(GL_TEXTURE_TYPE, num_samples, GL_RGBA8,
-                                      width_, height_, GL_FALSE);
-        } else {
-            glTexStorage2D(GL_TEXTURE_TYPE, num_samples, GL_RGBA8, width_,
-                           height_);
-        }
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_TYPE, texture[i], 0);
-
-        // Check FrameBuffer
-        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            fprintf(stderr, "GL FrameBuffer %i Error! %u\n", i, status);
-            return;
-        }
-    }
+    // Setup bloom shaders, which only ever read single-sample images
+    prefilter_shader.compile(src_copy_vert, src_bloom_prefilter_frag);
+    downsample_shader.compile(src_copy_vert, src_bloom_down_frag);
+    upsample_shader.compile(src_copy_vert, src_bloom_up_frag);
+    upsample_target_size = upsample_shader.uniform("target_size");
+    composite_shader.compile(src_copy_vert, src_bloom_composite_frag);
+    composite_target_size = composite_shader.uniform("target_size");
+
+    // Get the scene and resolve targets, only the scene is multisampled
+    buffer[0] = pool.acquire(width_, height_, num_samples);
+    if (resolved != 0) buffer[resolved] = pool.acquire(width_, height_);
 
-    // Reset buffers
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Halve the size until the chain is deep enough or the image is tiny
+    int width = width_;
+    int height = height_;
+    bloom_levels = 0;
+    while (bloom_levels < max_bloom_levels && width >= 4 && height >= 4) {
+        width /= 2;
+        height /= 2;
+        bloom[bloom_levels++] = pool.acquire(width, height);
+    }
 }
 
 void FrameBuffer::deinit() {
-    for (int i = 0; i < num_buffers; i++) {
-        glDeleteTextures(1, &texture[i]);
-        glDeleteFramebuffers(1, &buffer[i]);
-    }
+    // Keep the allocations in the pool for the next init()
+    for (int i = 0; i < num_buffers; i++) pool.release(buffer[i]);
+    for (int level = 0; level < bloom_levels; level++)
+        pool.release(bloom[level]);
+    bloom_levels = 0;
 }
 
 void FrameBuffer::set_resolution(const int width, const int height) {
-    width_ = width;
-    height_ = height;
+    output_width_ = width;
+    output_height_ = height;
+    resize_pending_ = false;
+    reallocate();
+}
+
+int FrameBuffer::scaled(const int size) const {
+    return std::max(1, (int)std::lround(size * scale_));
+}
+
+void FrameBuffer::reallocate() {
+    width_ = scaled(output_width_);
+    height_ = scaled(output_height_);
+    shared_params().resolution[0] = (float)width_;
+    shared_params().resolution[1] = (float)height_;
     deinit();
     init();
 }
 
-void FrameBuffer::bind() const {
+void FrameBuffer::request_resolution(const int width, const int height) {
+    output_width_ = width;
+    output_height_ = height;
+    resize_pending_ = true;
+    resize_time_ = std::chrono::steady_clock::now();
+}
+
+bool FrameBuffer::update_resolution() {
+    if (scaler_.enabled()) scale_ = scaler_.scale();
+
+    if (resize_pending_) {
+        if (std::chrono::steady_clock::now() - resize_time_ < resize_settle)
+            return false;
+        resize_pending_ = false;
+    }
+
+    if (scaled(output_width_) == width_ && scaled(output_height_) == height_)
+        return false;
+    reallocate();
+    return true;
+}
+
+void FrameBuffer::set_render_scale(const float scale) {
+    scaler_.set_budget(0);
+    scale_ = std::min(1.0f, std::max(min_render_scale, scale));
+}
+
+void FrameBuffer::set_frame_budget(const float milliseconds) {
+    scaler_.set_budget(milliseconds);
+    scale_ = scaler_.scale();
+}
+
+void FrameBuffer::bind() {
+    // The frame starts with the first draw into the scene
+    scaler_.begin_frame();
+
     // Bind FrameBuffer render target
-    glBindFramebuffer(GL_FRAMEBUFFER, buffer[0]);
-    glViewport(0, 0, width_, height_);
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, buffer[0].framebuffer);
+    gl_state::viewport(0, 0, width_, height_);
     if (bg_black) {
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        gl_state::clear_color(0.0f, 0.0f, 0.0f, 1.0f);
     } else {
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        gl_state::clear_color(1.0f, 1.0f, 1.0f, 1.0f);
     }
     glClear(GL_COLOR_BUFFER_BIT);
+
+    // Shared shader parameters, uploaded only if they changed
+    shared_params_.bind();
 }
 
 void FrameBuffer::unbind() const {
-    // Unbind FrameBuffer render target
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, width_, height_);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // Unbind FrameBuffer render target. No need to clear the target, draw()
+    // blits over all of it.
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, target_);
+    gl_state::viewport(0, 0, output_width_, output_height_);
 }
 
 void FrameBuffer::draw() {
+    // Resolve the samples once, everything below works on the resolved image
+    if (resolved != 0) {
+        GpuProfiler::Scope timer(profiler_, "resolve");
+        gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER, buffer[0].framebuffer);
+        gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER,
+                                   buffer[resolved].framebuffer);
+        glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
     if (do_bloom) {
+        GpuProfiler::Scope timer(profiler_, "bloom");
         apply_bloom();
     }
 
-    // Render offscreen buffer to screen
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer[0]);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
-                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    // Render resolved buffer to screen, upscaled from the render scale and
+    // while a resize is pending
+    const GLenum filter = (output_width_ == width_ && output_height_ == height_)
+                              ? GL_NEAREST
+                              : GL_LINEAR;
+    {
+        GpuProfiler::Scope timer(profiler_, "present");
+        gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER,
+                                   buffer[resolved].framebuffer);
+        gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, target_);
+        glBlitFramebuffer(0, 0, width_, height_, 0, 0, output_width_,
+                          output_height_, GL_COLOR_BUFFER_BIT, filter);
+    }
+
+    if (do_bloom) {
+        GpuProfiler::Scope timer(profiler_, "composite");
+        composite_bloom();
+    }
+
+    scaler_.end_frame();
 }
 
 void FrameBuffer::apply_bloom() {
-    // 1) texture 0 -> horizontal blur -> buffer 1
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, buffer[1]);
-    glViewport(0, 0, width_, height_);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (bloom_levels == 0) return;
 
-    hblur_shader.use();
-    glBindTexture(GL_TEXTURE_TYPE, texture[0]);
+    // 1) resolved scene -> 2x2 average -> level 0
+    gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, bloom[0].framebuffer);
+    gl_state::viewport(0, 0, bloom[0].width, bloom[0].height);
+
+    prefilter_shader.use();
+    gl_state::bind_texture(GL_TEXTURE_2D, buffer[resolved].texture);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-    // 2) texture 1 -> vertical blur --blend--> buffer 0
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, buffer[0]);
-    glViewport(0, 0, width_, height_);
+    // 2) level i -> downsample -> level i+1, blurring a little each time
+    downsample_shader.use();
+    for (int level = 1; level < bloom_levels; level++) {
+        gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER,
+                                   bloom[level].framebuffer);
+        gl_state::viewport(0, 0, bloom[level].width, bloom[level].height);
+        gl_state::bind_texture(GL_TEXTURE_2D, bloom[level - 1].texture);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    }
+
+    // 3) level i+1 -> upsample --add--> level i, widening the glow. The
+    //    levels are weighted so that the sum never saturates.
+    gl_state::set_blend(true);
+    gl_state::blend_equation(GL_FUNC_ADD);
+    gl_state::blend_color(0, 0, 0, bloom_spread);
+    gl_state::blend_func(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+
+    upsample_shader.use();
+    for (int level = bloom_levels - 2; level >= 0; level--) {
+        gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER,
+                                   bloom[level].framebuffer);
+        gl_state::viewport(0, 0, bloom[level].width, bloom[level].height);
+        upsample_shader.set_uniform(upsample_target_size,
+                                    (float)bloom[level].width,
+                                    (float)bloom[level].height);
+        gl_state::bind_texture(GL_TEXTURE_2D, bloom[level + 1].texture);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    }
+
+    gl_state::set_blend(false);
+}
+
+void FrameBuffer::composite_bloom() {
+    if (bloom_levels == 0) return;
+
+    // 4) level 0 --add--> target, which already holds the resolved scene
+    gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, target_);
+    gl_state::viewport(0, 0, output_width_, output_height_);
 
-    glEnable(GL_BLEND);  // Blend the blurred result with the original data
-    glBlendColor(0, 0, 0, 0.5);
-    glBlendFunc(GL_CONSTANT_ALPHA, GL_CONSTANT_ALPHA);
-    glBlendEquation(GL_FUNC_ADD);
+    gl_state::set_blend(true);
+    gl_state::blend_equation(GL_FUNC_ADD);
+    gl_state::blend_color(0, 0, 0, bloom_intensity);
+    gl_state::blend_func(GL_CONSTANT_ALPHA, GL_ONE);
 
-    vblur_shader.use();
-    glBindTexture(GL_TEXTURE_TYPE, texture[1]);
+    composite_shader.use();
+    composite_shader.set_uniform(composite_target_size, (float)output_width_,
+                                 (float)output_height_);
+    gl_state::bind_texture(GL_TEXTURE_2D, bloom[0].texture);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-    glDisable(GL_BLEND);
-    unbind();
+    gl_state::set_blend(false);
 }
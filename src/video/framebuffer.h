@@ -1,16 +1,41 @@
 #ifndef FRAMEBUFFER_H
 #define FRAMEBUFFER_H
 
+#include <chrono>
+
+#include "gpu_profiler.h"
+#include "render_target_pool.h"
+#include "resolution_scaler.h"
 #include "shader_program.h"
+#include "uniform_buffer.h"
 
 class FrameBuffer {
    public:
     FrameBuffer(const int width, const int height, const bool do_msaa);
     virtual ~FrameBuffer();
-    void bind() const;
+    void bind();
     void unbind() const;
     void draw();
+    // Output size; the scene and post-processing run at the render scale of
+    // it and are upscaled when presented
     void set_resolution(const int width, const int height);
+    // Debounced resize: the current targets are presented scaled to the new
+    // size until no further request has arrived for a short while, then
+    // update_resolution() reallocates once. It also follows changes of the
+    // render scale, and returns true when the render size changed.
+    void request_resolution(const int width, const int height);
+    bool update_resolution();
+    // Fixed share of the output size to render at, clamped to [0.25, 1]
+    void set_render_scale(const float scale);
+    // Scale automatically to keep the GPU time of a frame within budget.
+    // Either takes effect at the next update_resolution().
+    void set_frame_budget(const float milliseconds);
+    float render_scale() const { return scale_; }
+    bool resize_pending() const { return resize_pending_; }
+    void set_target(GLuint framebuffer) { target_ = framebuffer; }
+    // Times the post-processing passes of draw(), null to stop
+    void set_profiler(GpuProfiler* profiler) { profiler_ = profiler; }
+    // Render size
     int width() const { return width_; }
     int height() const { return height_; }
     void set_bloom(bool in) { do_bloom = in; }
@@ -24,25 +49,51 @@ class FrameBuffer {
     bool bloom_enabled() const { return do_bloom; }
     bool msaa_enabled() const { return do_msaa; }
 
+    // Uploaded and bound to SharedParams::binding by bind()
+    SharedParams& shared_params() { return shared_params_.data(); }
+
    private:
     int width_;
     int height_;
     bool do_msaa;
+    GLuint target_ = 0;  // Framebuffer that draw() presents into
+    GpuProfiler* profiler_ = nullptr;
+    int output_width_;   // Size of the presented image in target_
+    int output_height_;
+    bool resize_pending_ = false;
+    std::chrono::steady_clock::time_point resize_time_;
+    float scale_ = 1;
+    ResolutionScaler scaler_;
+    UniformBuffer<SharedParams> shared_params_;
 
-    const int num_buffers = 2;
+    int num_buffers;
+    int resolved;  // Buffer holding the single-sample scene
     int num_samples;
     bool do_bloom = true;
     bool bg_black = true;
-    GLenum GL_TEXTURE_TYPE;
-    GLuint buffer[3];
-    GLuint texture[3];
+    RenderTargetPool pool;
+    RenderTarget buffer[2];
 
     ShaderProgram copy_shader;
-    ShaderProgram hblur_shader;
-    ShaderProgram vblur_shader;
+
+    // Bloom mip chain, each level half the size of the one before
+    static constexpr int max_bloom_levels = 6;
+    int bloom_levels = 0;
+    RenderTarget bloom[max_bloom_levels];
+    ShaderProgram prefilter_shader;
+    ShaderProgram downsample_shader;
+    ShaderProgram upsample_shader;
+    ShaderProgram composite_shader;
+    UniformHandle upsample_target_size;
+    UniformHandle composite_target_size;
+
     void init();
     void deinit();
+    void reallocate();
+    int scaled(const int size) const;
+    void init_bloom();
     void apply_bloom();
+    void composite_bloom();
 };
 
 #endif /* FRAMEBUFFER_H */
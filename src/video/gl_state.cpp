@@ -0,0 +1,151 @@
+#include "gl_state.h"
+
+namespace gl_state {
+
+// Never a valid object name or enum, so the first call always goes through
+static constexpr GLuint unknown = ~0u;
+
+struct State {
+    GLuint program = unknown;
+    GLuint vertex_array = unknown;
+    GLuint draw_framebuffer = unknown;
+    GLuint read_framebuffer = unknown;
+    GLuint texture_2d = unknown;
+    GLuint texture_2d_multisample = unknown;
+    GLuint texture_2d_array = unknown;
+    GLint viewport[4] = {-1, -1, -1, -1};
+
+    GLenum blend = unknown;  // GL_TRUE, GL_FALSE or unknown
+    GLenum blend_source = unknown;
+    GLenum blend_destination = unknown;
+    GLenum blend_equation = unknown;
+    bool blend_color_known = false;
+    GLfloat blend_color[4];
+    bool clear_color_known = false;
+    GLfloat clear_color[4];
+};
+
+static thread_local State state;
+
+static bool update(GLuint &cached, GLuint value) {
+    if (cached == value) return false;
+    cached = value;
+    return true;
+}
+
+static bool update(bool &known, GLfloat (&cached)[4], GLfloat red,
+                   GLfloat green, GLfloat blue, GLfloat alpha) {
+    if (known && cached[0] == red && cached[1] == green &&
+        cached[2] == blue && cached[3] == alpha)
+        return false;
+    known = true;
+    cached[0] = red;
+    cached[1] = green;
+    cached[2] = blue;
+    cached[3] = alpha;
+    return true;
+}
+
+void use_program(GLuint program) {
+    if (update(state.program, program)) glUseProgram(program);
+}
+
+void bind_vertex_array(GLuint vertex_array) {
+    if (update(state.vertex_array, vertex_array))
+        glBindVertexArray(vertex_array);
+}
+
+void bind_framebuffer(GLenum target, GLuint framebuffer) {
+    if (target == GL_FRAMEBUFFER) {
+        if (state.draw_framebuffer == framebuffer &&
+            state.read_framebuffer == framebuffer)
+            return;
+        state.draw_framebuffer = state.read_framebuffer = framebuffer;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    } else if (target == GL_DRAW_FRAMEBUFFER) {
+        if (update(state.draw_framebuffer, framebuffer))
+            glBindFramebuffer(target, framebuffer);
+    } else {
+        if (update(state.read_framebuffer, framebuffer))
+            glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void bind_texture(GLenum target, GLuint texture) {
+    GLuint &cached = target == GL_TEXTURE_2D_MULTISAMPLE
+                         ? state.texture_2d_multisample
+                     : target == GL_TEXTURE_2D_ARRAY ? state.texture_2d_array
+                                                     : state.texture_2d;
+    if (update(cached, texture)) glBindTexture(target, texture);
+}
+
+void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    GLint *cached = state.viewport;
+    if (cached[0] == x && cached[1] == y && cached[2] == width &&
+        cached[3] == height)
+        return;
+    cached[0] = x;
+    cached[1] = y;
+    cached[2] = width;
+    cached[3] = height;
+    glViewport(x, y, width, height);
+}
+
+void set_blend(bool enabled) {
+    if (!update(state.blend, enabled ? GL_TRUE : GL_FALSE)) return;
+    if (enabled) {
+        glEnable(GL_BLEND);
+    } else {
+        glDisable(GL_BLEND);
+    }
+}
+
+void blend_func(GLenum source, GLenum destination) {
+    if (state.blend_source == source &&
+        state.blend_destination == destination)
+        return;
+    state.blend_source = source;
+    state.blend_destination = destination;
+    glBlendFunc(source, destination);
+}
+
+void blend_equation(GLenum mode) {
+    if (update(state.blend_equation, mode)) glBlendEquation(mode);
+}
+
+void blend_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    if (update(state.blend_color_known, state.blend_color, red, green, blue,
+               alpha))
+        glBlendColor(red, green, blue, alpha);
+}
+
+void clear_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    if (update(state.clear_color_known, state.clear_color, red, green, blue,
+               alpha))
+        glClearColor(red, green, blue, alpha);
+}
+
+void forget_program(GLuint program) {
+    // A deleted program stays current until another one is used
+    if (state.program == program) state.program = unknown;
+}
+
+void forget_vertex_array(GLuint vertex_array) {
+    if (state.vertex_array == vertex_array) state.vertex_array = 0;
+}
+
+void forget_framebuffer(GLuint framebuffer) {
+    if (state.draw_framebuffer == framebuffer) state.draw_framebuffer = 0;
+    if (state.read_framebuffer == framebuffer) state.read_framebuffer = 0;
+}
+
+void forget_texture(GLuint texture) {
+    if (state.texture_2d == texture) state.texture_2d = 0;
+    if (state.texture_2d_multisample == texture)
+        state.texture_2d_multisample = 0;
+    if (state.texture_2d_array == texture) state.texture_2d_array = 0;
+}
+
+void invalidate() { state = State(); }
+
+}  // namespace gl_state
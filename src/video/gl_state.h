@@ -0,0 +1,39 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state that changes per pass, skipping calls that
+// would set what is already set. The copy belongs to the calling thread,
+// which matches one context per thread as used by the window and the export
+// workers. Code that changes this state with raw GL calls must call
+// invalidate() afterwards.
+namespace gl_state {
+
+void use_program(GLuint program);
+void bind_vertex_array(GLuint vertex_array);
+// GL_FRAMEBUFFER binds both the draw and the read framebuffer
+void bind_framebuffer(GLenum target, GLuint framebuffer);
+// Texture unit 0, the only one in use
+void bind_texture(GLenum target, GLuint texture);
+void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+void set_blend(bool enabled);
+void blend_func(GLenum source, GLenum destination);
+void blend_equation(GLenum mode);
+void blend_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void clear_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+// Deleting a bound object reverts its binding to 0 and frees the name for
+// reuse, so the shadow copy has to follow
+void forget_program(GLuint program);
+void forget_vertex_array(GLuint vertex_array);
+void forget_framebuffer(GLuint framebuffer);
+void forget_texture(GLuint texture);
+
+// Assume nothing about the current state
+void invalidate();
+
+}  // namespace gl_state
+
+#endif /* GL_STATE_H */
@@ -0,0 +1,131 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>  // nth_element
+#include <cstdio>
+
+void GpuProfiler::Samples::push(float value) {
+    if (values.size() < num_samples) {
+        values.push_back(value);
+    } else {
+        values[next] = value;
+    }
+    next = (next + 1) % num_samples;
+}
+
+void GpuProfiler::Samples::percentiles(float& median, float& p95) const {
+    median = p95 = 0;
+    if (values.empty()) return;
+
+    std::vector<float> sorted = values;
+    const size_t mid = sorted.size() / 2;
+    const size_t high = (sorted.size() * 95) / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + mid, sorted.end());
+    median = sorted[mid];
+    std::nth_element(sorted.begin(), sorted.begin() + high, sorted.end());
+    p95 = sorted[high];
+}
+
+GpuProfiler::GpuProfiler(bool blocking) : blocking_(blocking) {}
+
+GpuProfiler::~GpuProfiler() {
+    for (Pass& pass : passes_) glDeleteQueries(num_frames, pass.queries);
+}
+
+void GpuProfiler::begin_frame() {
+    const auto now = std::chrono::steady_clock::now();
+    if (started_) {
+        std::chrono::duration<float, std::milli> elapsed = now - frame_start_;
+        cpu_ms_.push(elapsed.count());
+    }
+    started_ = true;
+    frame_start_ = now;
+
+    // Read back the slot issued num_frames ago before reusing it
+    frame_ = (frame_ + 1) % num_frames;
+    collect(frame_);
+}
+
+void GpuProfiler::collect(int slot) {
+    for (Pass& pass : passes_) {
+        if (!pass.issued[slot]) continue;
+        pass.issued[slot] = false;
+
+        // Reading GL_QUERY_RESULT waits for the GPU if it is not ready yet
+        if (!blocking_) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE,
+                               &available);
+            if (available != GL_TRUE) continue;
+        }
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT,
+                              &nanoseconds);
+        pass.gpu_ms.push(nanoseconds * 1e-6f);
+    }
+}
+
+void GpuProfiler::finish() {
+    end();
+    glFinish();
+    for (int slot = 0; slot < num_frames; slot++) collect(slot);
+}
+
+void GpuProfiler::begin(const char* name) {
+    if (frame_ < 0 || active_ >= 0) return;
+
+    // Few passes, a linear search is cheaper than hashing the name
+    size_t idx = 0;
+    while (idx < passes_.size() && passes_[idx].name != name) idx++;
+    if (idx == passes_.size()) {
+        passes_.emplace_back();
+        passes_.back().name = name;
+        glGenQueries(num_frames, passes_.back().queries);
+    }
+
+    Pass& pass = passes_[idx];
+    if (pass.issued[frame_]) return;  // Each pass is timed once per frame
+    glBeginQuery(GL_TIME_ELAPSED, pass.queries[frame_]);
+    pass.issued[frame_] = true;
+    active_ = idx;
+}
+
+void GpuProfiler::end() {
+    if (active_ < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    active_ = -1;
+}
+
+bool GpuProfiler::percentiles(const char* name, float& median,
+                              float& p95) const {
+    for (const Pass& pass : passes_) {
+        if (pass.name != name) continue;
+        pass.gpu_ms.percentiles(median, p95);
+        return !pass.gpu_ms.values.empty();
+    }
+    median = p95 = 0;
+    return false;
+}
+
+size_t GpuProfiler::sample_count(const char* name) const {
+    for (const Pass& pass : passes_)
+        if (pass.name == name) return pass.gpu_ms.values.size();
+    return 0;
+}
+
+std::string GpuProfiler::report() const {
+    std::string text;
+    char entry[96];
+    float median, p95;
+    for (const Pass& pass : passes_) {
+        pass.gpu_ms.percentiles(median, p95);
+        snprintf(entry, sizeof(entry), "%s %.2f/%.2f  ", pass.name.c_str(),
+                 median, p95);
+        text.append(entry);
+    }
+    cpu_ms_.percentiles(median, p95);
+    snprintf(entry, sizeof(entry), "| cpu frame %.2f/%.2f",
+             median, p95);
+    text.append(entry);
+    return text;
+}
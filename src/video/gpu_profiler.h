@@ -0,0 +1,85 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Measures the GPU time of named render passes with GL_TIME_ELAPSED queries.
+// Queries of a frame are only read back when their ring slot comes around
+// again a few frames later, so measuring never stalls the pipeline; results
+// that are still not available then are dropped. Passes must not nest.
+//
+// A blocking profiler waits for every result instead of dropping it. Dropped
+// results are those of the slowest frames, which would bias benchmark
+// statistics low.
+class GpuProfiler {
+   public:
+    explicit GpuProfiler(bool blocking = false);
+    ~GpuProfiler();
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    void begin_frame();
+    void begin(const char* pass);
+    void end();
+
+    // Wait for the GPU and collect every outstanding query
+    void finish();
+
+    // Rolling median and 95th percentile of every pass and of the CPU time
+    // between frames, in milliseconds
+    std::string report() const;
+    bool percentiles(const char* pass, float& median, float& p95) const;
+
+    // Number of results the statistics of a pass are computed from
+    size_t sample_count(const char* pass) const;
+
+    // Times a pass for the lifetime of the scope, a null profiler is allowed
+    class Scope {
+       public:
+        Scope(GpuProfiler* profiler, const char* pass) : profiler_(profiler) {
+            if (profiler_) profiler_->begin(pass);
+        }
+        ~Scope() {
+            if (profiler_) profiler_->end();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        GpuProfiler* const profiler_;
+    };
+
+   private:
+    static constexpr int num_frames = 4;       // Depth of the query ring
+    static constexpr size_t num_samples = 240;  // Window of the statistics
+
+    struct Samples {
+        std::vector<float> values;  // Ring of the latest num_samples
+        size_t next = 0;
+        void push(float value);
+        void percentiles(float& median, float& p95) const;
+    };
+
+    struct Pass {
+        std::string name;
+        GLuint queries[num_frames];
+        bool issued[num_frames] = {};
+        Samples gpu_ms;
+    };
+
+    const bool blocking_;
+    std::vector<Pass> passes_;
+    Samples cpu_ms_;
+    int frame_ = -1;
+    int active_ = -1;
+    bool started_ = false;
+    std::chrono::steady_clock::time_point frame_start_;
+
+    void collect(int slot);
+};
+
+#endif /* GPU_PROFILER_H */
@@ -0,0 +1,186 @@
+#include "offline_renderer.h"
+
+#include <algorithm>  // max, min
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "video/frame_reader.h"
+#include "video/framebuffer.h"
+#include "video/gl_state.h"
+#include "video/offscreen_context.h"
+#include "video/video_encoder.h"
+#include "visuals/eclipse/eclipse.h"
+
+// Sample the player would report when the given frame is presented
+static unsigned long frame_sample(const unsigned long frame,
+                                  const unsigned long sample_rate,
+                                  const unsigned long fps) {
+    return std::max(1ul, (frame * sample_rate + fps / 2) / fps);
+}
+
+// Insert a segment number before the extension: out.mp4 -> out.part3.mp4
+static std::string segment_filename(const std::string &output,
+                                    const unsigned int index) {
+    const std::string suffix = ".part" + std::to_string(index);
+    const size_t dot = output.find_last_of('.');
+    const size_t slash = output.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return output + suffix;
+    return output.substr(0, dot) + suffix + output.substr(dot);
+}
+
+// Render frames [first, last) into the encoder, using a headless context of
+// its own so that several ranges can be rendered concurrently
+static void render_range(const IAudioSource &audio_source,
+                         const RenderSettings &settings,
+                         const unsigned long first, const unsigned long last,
+                         VideoEncoder &encoder,
+                         std::atomic<unsigned long> &frames_done) {
+    const int width = settings.width;
+    const int height = settings.height;
+    const unsigned long fps = settings.fps;
+    const unsigned long sample_rate = audio_source.sample_rate();
+
+    OffscreenContext context;
+
+    // Headless contexts have no default framebuffer, so present into our own
+    GLuint target, renderbuffer;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &target);
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, target);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, renderbuffer);
+
+    {
+        FrameBuffer fb(width, height, settings.msaa);
+        fb.set_bloom(settings.bloom);
+        fb.set_target(target);
+
+        EclipseVisual visual(audio_source, fb);
+
+        // Disable depth, enable alpha blending
+        glDisable(GL_DEPTH_TEST);
+        gl_state::set_blend(true);
+        gl_state::blend_func(GL_ONE, GL_ONE);
+        glDepthMask(false);
+
+        context.check_errors();
+
+        // Draw the preceding frame without keeping it, so the GL state at the
+        // first frame matches an uninterrupted render of the whole track
+        if (first > 0) {
+            visual.draw(frame_sample(first - 1, sample_rate, fps));
+            fb.draw();
+        }
+
+        FrameReader reader(width, height);
+        for (unsigned long frame = first; frame < last; frame++) {
+            visual.draw(frame_sample(frame, sample_rate, fps));
+            fb.draw();
+
+            // Encode the previous frame while this one is read back
+            const unsigned char *pixels = reader.read(target);
+            if (pixels) encoder.write_frame(pixels);
+            frames_done++;
+        }
+
+        const unsigned char *pixels = reader.finish();
+        if (pixels) encoder.write_frame(pixels);
+
+        context.check_errors();
+    }
+
+    gl_state::forget_framebuffer(target);
+    glDeleteFramebuffers(1, &target);
+    glDeleteRenderbuffers(1, &renderbuffer);
+}
+
+void render_offline(const IAudioSource &audio_source,
+                    const RenderSettings &settings) {
+    const int width = settings.width;
+    const int height = settings.height;
+    const int fps = settings.fps;
+    const unsigned long sample_rate = audio_source.sample_rate();
+    const unsigned long num_frames =
+        (audio_source.num_samples() * fps + sample_rate - 1) / sample_rate;
+
+    // One contiguous range of the timeline per worker
+    unsigned long num_workers = std::thread::hardware_concurrency();
+    if (settings.threads > 0) num_workers = settings.threads;
+    num_workers = std::max(1ul, std::min(num_workers, num_frames));
+
+    // A single worker encodes straight into the output with the audio,
+    // otherwise each worker writes a video-only segment that is joined later
+    std::vector<std::string> segments;
+    std::vector<unsigned long> first_frames;
+    for (unsigned long idx = 0; idx < num_workers; idx++) {
+        first_frames.push_back(idx * num_frames / num_workers);
+        if (num_workers == 1)
+            segments.push_back(settings.output);
+        else
+            segments.push_back(segment_filename(settings.output, idx));
+    }
+
+    std::atomic<unsigned long> frames_done(0);
+    std::atomic<unsigned long> workers_done(0);
+    std::vector<std::exception_ptr> errors(num_workers);
+    std::vector<std::thread> workers;
+    for (unsigned long idx = 0; idx < num_workers; idx++) {
+        workers.emplace_back([&, idx]() {
+            const unsigned long first = first_frames[idx];
+            const unsigned long last = idx + 1 < num_workers
+                                           ? first_frames[idx + 1]
+                                           : num_frames;
+            try {
+                VideoEncoder encoder(segments[idx], width, height, fps,
+                                     num_workers == 1 ? &audio_source
+                                                      : nullptr);
+                render_range(audio_source, settings, first, last, encoder,
+                             frames_done);
+                encoder.finish();
+            } catch (...) {
+                errors[idx] = std::current_exception();
+            }
+            workers_done++;
+        });
+    }
+
+    // Report progress until every worker is done
+    auto start = std::chrono::steady_clock::now();
+    while (workers_done < num_workers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        const double elapsed = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        printf("\rFrame %lu/%lu (fps: %4.4f, workers: %lu)",
+               frames_done.load(), num_frames, frames_done / elapsed,
+               num_workers);
+        fflush(stdout);
+    }
+    for (auto &worker : workers) worker.join();
+    printf("\n");
+
+    std::exception_ptr error = nullptr;
+    for (auto &e : errors)
+        if (e && !error) error = e;
+
+    if (num_workers > 1) {
+        if (!error) {
+            try {
+                concatenate_segments(segments, first_frames, settings.output,
+                                     fps, audio_source);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        for (const auto &segment : segments) std::remove(segment.c_str());
+    }
+
+    if (error) std::rethrow_exception(error);
+}
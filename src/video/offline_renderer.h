@@ -0,0 +1,24 @@
+#ifndef OFFLINE_RENDERER_H
+#define OFFLINE_RENDERER_H
+
+#include <string>
+
+#include "audio/i_source.h"
+
+struct RenderSettings {
+    std::string output;  // Video file, container chosen by extension
+    int width = 1920;
+    int height = 1080;
+    int fps = 60;
+    bool msaa = true;
+    bool bloom = true;
+    int threads = 0;  // Parallel render workers, 0 for one per core
+};
+
+// Render the whole audio source into a video file in headless contexts,
+// stepping the visual at exact sample positions as fast as possible. The
+// timeline is split into contiguous ranges rendered by parallel workers.
+void render_offline(const IAudioSource &audio_source,
+                    const RenderSettings &settings);
+
+#endif /* OFFLINE_RENDERER_H */
@@ -0,0 +1,115 @@
+#include "offscreen_context.h"
+
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+#include "gl_state.h"
+
+// The EGL display is shared by every context in the process, so it is only
+// terminated once the last context is gone
+static std::mutex display_mutex;
+static EGLDisplay shared_display = EGL_NO_DISPLAY;
+static int display_users = 0;
+
+static EGLDisplay acquire_display() {
+    std::lock_guard<std::mutex> lock(display_mutex);
+    if (display_users == 0) {
+        // Prefer the surfaceless platform, which needs no X11 or GBM device
+        auto get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+                "eglGetPlatformDisplayEXT");
+        if (get_platform_display)
+            shared_display = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (shared_display == EGL_NO_DISPLAY)
+            shared_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (shared_display == EGL_NO_DISPLAY ||
+            !eglInitialize(shared_display, NULL, NULL))
+            throw std::runtime_error("Unable to initialize EGL display");
+    }
+    display_users++;
+    return shared_display;
+}
+
+static void release_display() {
+    std::lock_guard<std::mutex> lock(display_mutex);
+    if (--display_users == 0) {
+        eglTerminate(shared_display);
+        shared_display = EGL_NO_DISPLAY;
+    }
+}
+
+OffscreenContext::OffscreenContext() {
+    status = 0;
+    display = acquire_display();
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        release_display();
+        throw std::runtime_error("EGL does not support desktop OpenGL");
+    }
+
+    const EGLint config_attribs[] = {EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE,
+                                     EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) ||
+        num_configs < 1) {
+        release_display();
+        throw std::runtime_error("No suitable EGL config");
+    }
+
+    const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                      4,
+                                      EGL_CONTEXT_MINOR_VERSION,
+                                      1,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                      EGL_NONE};
+    context =
+        eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT) {
+        release_display();
+        throw std::runtime_error("Unable to create EGL context");
+    }
+
+    make_current();
+
+    // GLEW entry points are process-wide, so initialize them one at a time.
+    // A GLX-enabled GLEW reports a missing X display after it has already
+    // loaded the core entry points, which is harmless here.
+    static std::mutex glew_mutex;
+    std::lock_guard<std::mutex> lock(glew_mutex);
+    glewExperimental = GL_TRUE;
+    GLenum glewError = glewInit();
+    if (glewError != GLEW_OK && glewError != GLEW_ERROR_NO_GLX_DISPLAY) {
+        printf("Error initializing GLEW! %s\n", glewGetErrorString(glewError));
+    }
+    glGetError();  // GLEW may leave an error behind on core profiles
+
+    // A new context starts from the GL defaults, not this thread's last one
+    gl_state::invalidate();
+}
+
+OffscreenContext::~OffscreenContext() {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    release_display();
+}
+
+void OffscreenContext::make_current() {
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        throw std::runtime_error("Unable to make EGL context current");
+    gl_state::invalidate();
+}
+
+void OffscreenContext::check_errors() {
+    GLenum err;
+    while ((err = glGetError()) != GL_NO_ERROR) {
+        fprintf(stderr, "GL Error! %u\n", err);
+        status = err;
+    }
+    return;
+}
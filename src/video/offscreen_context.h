@@ -0,0 +1,26 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+#include <EGL/egl.h>
+#include <GL/glew.h>
+
+// Headless OpenGL 4.1 core context without any window or default
+// framebuffer, created on the EGL surfaceless platform so it also works under
+// llvmpipe with no display. The context is current on the creating thread.
+class OffscreenContext {
+   public:
+    OffscreenContext();
+    ~OffscreenContext();
+    OffscreenContext(const OffscreenContext &) = delete;
+    OffscreenContext &operator=(const OffscreenContext &) = delete;
+
+    void make_current();
+    void check_errors();
+
+   private:
+    int status;
+    EGLDisplay display;
+    EGLContext context;
+};
+
+#endif /* OFFSCREEN_CONTEXT_H */
@@ -0,0 +1,176 @@
+#include "program_cache.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+
+namespace program_cache {
+
+struct Binary {
+    GLenum format;
+    std::vector<char> data;
+};
+
+static std::mutex cache_mutex;
+static std::unordered_map<uint64_t, Binary> memory_cache;
+
+static uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+    for (size_t idx = 0; idx < size; idx++) {
+        hash ^= (unsigned char)data[idx];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t fnv1a(uint64_t hash, const std::string& str) {
+    // Include the terminator so that adjacent strings cannot alias
+    return fnv1a(hash, str.c_str(), str.size() + 1);
+}
+
+static std::string driver() {
+    std::string info;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* str = glGetString(name);
+        if (str) info.append((const char*)str);
+        info.push_back('\n');
+    }
+    return info;
+}
+
+static bool supported() {
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+}
+
+// Directory for binaries, created on first use; empty if unavailable
+static const std::string& directory() {
+    static const std::string dir = [] {
+        std::string base;
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+            base = xdg;
+        } else if (const char* home = std::getenv("HOME")) {
+            base = std::string(home) + "/.cache";
+        } else {
+            return std::string();
+        }
+        mkdir(base.c_str(), 0755);
+        std::string dir = base + "/audioviz";
+        mkdir(dir.c_str(), 0755);
+
+        struct stat info;
+        if (stat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            return std::string();
+        return dir;
+    }();
+    return dir;
+}
+
+static std::string filename(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return directory() + name;
+}
+
+static bool read_file(uint64_t key, Binary& binary) {
+    if (directory().empty()) return false;
+    FILE* file = fopen(filename(key).c_str(), "rb");
+    if (!file) return false;
+
+    uint32_t format = 0;
+    bool success = fread(&format, sizeof(format), 1, file) == 1;
+    if (success) {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file) - (long)sizeof(format);
+        fseek(file, sizeof(format), SEEK_SET);
+        success = size > 0;
+        if (success) {
+            binary.format = format;
+            binary.data.resize(size);
+            success = fread(binary.data.data(), size, 1, file) == 1;
+        }
+    }
+    fclose(file);
+    return success;
+}
+
+static void write_file(uint64_t key, const Binary& binary) {
+    if (directory().empty()) return;
+
+    // Write to a temporary file first so readers never see partial binaries
+    const std::string path = filename(key);
+    const std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file) return;
+
+    const uint32_t format = binary.format;
+    bool success = fwrite(&format, sizeof(format), 1, file) == 1 &&
+                   fwrite(binary.data.data(), binary.data.size(), 1, file) == 1;
+    success = (fclose(file) == 0) && success;
+    if (!success || rename(temp.c_str(), path.c_str()) != 0)
+        remove(temp.c_str());
+}
+
+uint64_t key(const std::string& vertex_source,
+             const std::string& fragment_source) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = fnv1a(hash, GLSL_version);
+    hash = fnv1a(hash, driver());
+    hash = fnv1a(hash, vertex_source);
+    hash = fnv1a(hash, fragment_source);
+    return hash;
+}
+
+bool load(uint64_t key, GLuint program) {
+    if (!supported()) return false;
+
+    Binary binary;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = memory_cache.find(key);
+        if (it != memory_cache.end()) {
+            binary = it->second;
+        } else if (!read_file(key, binary)) {
+            return false;
+        }
+    }
+
+    glProgramBinary(program, binary.format, binary.data.data(),
+                    binary.data.size());
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (linked != GL_TRUE) {
+        // Stale or corrupt, forget it so the next link replaces it
+        memory_cache.erase(key);
+        return false;
+    }
+    memory_cache.emplace(key, std::move(binary));
+    return true;
+}
+
+void store(uint64_t key, GLuint program) {
+    if (!supported()) return;
+
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) return;
+
+    Binary binary;
+    binary.data.resize(size);
+    glGetProgramBinary(program, size, NULL, &binary.format,
+                       binary.data.data());
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    write_file(key, binary);
+    memory_cache[key] = std::move(binary);
+}
+
+}  // namespace program_cache
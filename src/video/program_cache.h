@@ -0,0 +1,28 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+// Cache of linked program binaries, shared by all contexts of the process
+// and persisted under $XDG_CACHE_HOME/audioviz (or ~/.cache/audioviz).
+// Entries are keyed by the shader sources, the GLSL version and the driver,
+// so a driver update simply misses and recompiles.
+namespace program_cache {
+
+// Key for the given sources under the driver of the current context
+uint64_t key(const std::string& vertex_source,
+             const std::string& fragment_source);
+
+// Try to restore a cached binary into program; false if there is none or the
+// driver rejected it
+bool load(uint64_t key, GLuint program);
+
+// Remember the binary of a freshly linked program
+void store(uint64_t key, GLuint program);
+
+}  // namespace program_cache
+
+#endif /* PROGRAM_CACHE_H */
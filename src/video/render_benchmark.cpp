@@ -0,0 +1,209 @@
+#include "render_benchmark.h"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <algorithm>  // sort
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "audio/synthetic_source.h"
+#include "video/framebuffer.h"
+#include "video/gl_state.h"
+#include "video/gpu_profiler.h"
+#include "video/offscreen_context.h"
+#include "visuals/eclipse/eclipse.h"
+#include "visuals/liquid/liquid.h"
+#include "visuals/scope/scope.h"
+#include "visuals/waterfall/waterfall.h"
+
+static constexpr unsigned long sample_rate = 44100;
+static constexpr unsigned long fps = 60;
+
+// Golden frames may differ by a few levels between GL drivers; a frame
+// fails when more than this share of its channels differ by more than that
+static constexpr int max_level_difference = 8;
+static constexpr double max_differing_share = 0.001;
+
+static std::unique_ptr<IVisual> create_visual(const std::string &name,
+                                              const IAudioSource &source,
+                                              FrameBuffer &fb) {
+    if (name == "liquid") return std::make_unique<LiquidVisual>(source, fb);
+    if (name == "scope") return std::make_unique<ScopeVisual>(source, fb);
+    if (name == "waterfall")
+        return std::make_unique<WaterfallVisual>(source, fb);
+    return std::make_unique<EclipseVisual>(source, fb);
+}
+
+// Read the target back as top-down RGBA rows, as image files store them
+static std::vector<unsigned char> read_frame(GLuint target, int width,
+                                             int height) {
+    std::vector<unsigned char> pixels(4 * width * height);
+    gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER, target);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+
+    const size_t stride = 4 * width;
+    for (int row = 0; row < height / 2; row++)
+        std::swap_ranges(pixels.begin() + row * stride,
+                         pixels.begin() + (row + 1) * stride,
+                         pixels.begin() + (height - row - 1) * stride);
+    return pixels;
+}
+
+static bool save_png(const std::string &filename,
+                     std::vector<unsigned char> &pixels, int width,
+                     int height) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        pixels.data(), width, height, 32, 4 * width, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) return false;
+    const bool saved = IMG_SavePNG(surface, filename.c_str()) == 0;
+    SDL_FreeSurface(surface);
+    return saved;
+}
+
+// "match", "mismatch" or "missing"
+static const char *compare_png(const std::string &filename,
+                               const std::vector<unsigned char> &pixels,
+                               int width, int height) {
+    SDL_Surface *loaded = IMG_Load(filename.c_str());
+    if (!loaded) return "missing";
+    SDL_Surface *golden =
+        SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!golden) return "missing";
+
+    bool match = golden->w == width && golden->h == height;
+    if (match) {
+        unsigned long differing = 0;
+        const unsigned char *golden_pixels =
+            (const unsigned char *)golden->pixels;
+        for (int row = 0; row < height; row++) {
+            const unsigned char *expected = golden_pixels + row * golden->pitch;
+            const unsigned char *actual = pixels.data() + row * 4 * width;
+            for (int idx = 0; idx < 4 * width; idx++)
+                if (abs(expected[idx] - actual[idx]) > max_level_difference)
+                    differing++;
+        }
+        match = differing <= max_differing_share * pixels.size();
+    }
+    SDL_FreeSurface(golden);
+    return match ? "match" : "mismatch";
+}
+
+// Render one case and print its JSON line; false on a golden mismatch
+static bool run_case(const IAudioSource &source, const std::string &visual_name,
+                     bool msaa, bool bloom, int width, int height,
+                     const RenderBenchSettings &settings,
+                     OffscreenContext &context) {
+    // Headless contexts have no default framebuffer, so present into our own
+    GLuint target, renderbuffer;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &target);
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, target);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, renderbuffer);
+
+    std::vector<double> cpu_ms;
+    // Wait for every frame's GPU time, the slow ones must not be dropped
+    GpuProfiler profiler(true);
+    std::vector<unsigned char> pixels;
+    {
+        FrameBuffer fb(width, height, msaa);
+        fb.set_bloom(bloom);
+        fb.set_target(target);
+        std::unique_ptr<IVisual> visual =
+            create_visual(visual_name, source, fb);
+
+        // Disable depth, enable alpha blending
+        glDisable(GL_DEPTH_TEST);
+        gl_state::set_blend(true);
+        gl_state::blend_func(GL_ONE, GL_ONE);
+        glDepthMask(false);
+
+        // Analyse only the two grid frames around every timed position, so
+        // the timed frames interpolate between fixed spectra instead of
+        // running transforms
+        const unsigned long start = sample_rate;
+        const double hop =
+            start + (double)settings.frames * sample_rate / fps + 1;
+        visual->set_analysis_rate(sample_rate / hop);
+
+        // Warm up shaders, allocations and both spectra outside of the timed
+        // frames
+        visual->draw(start);
+        fb.draw();
+        glFinish();
+
+        for (int frame = 1; frame <= settings.frames; frame++) {
+            profiler.begin_frame();
+            const auto begin = std::chrono::steady_clock::now();
+            {
+                GpuProfiler::Scope timer(&profiler, "frame");
+                visual->draw(start + frame * sample_rate / fps);
+                fb.draw();
+            }
+            const auto end = std::chrono::steady_clock::now();
+            cpu_ms.push_back(
+                std::chrono::duration<double, std::milli>(end - begin)
+                    .count());
+        }
+        profiler.finish();
+
+        pixels = read_frame(target, width, height);
+        context.check_errors();
+    }
+
+    gl_state::forget_framebuffer(target);
+    glDeleteFramebuffers(1, &target);
+    glDeleteRenderbuffers(1, &renderbuffer);
+
+    const std::string name = visual_name + (msaa ? "_msaa" : "_nomsaa") +
+                             (bloom ? "_bloom_" : "_nobloom_") +
+                             std::to_string(width) + "x" +
+                             std::to_string(height) + ".png";
+    if (!settings.dump_dir.empty() &&
+        !save_png(settings.dump_dir + "/" + name, pixels, width, height))
+        fprintf(stderr, "Could not write %s: %s\n", name.c_str(),
+                IMG_GetError());
+    const char *golden = "unchecked";
+    if (!settings.golden_dir.empty())
+        golden = compare_png(settings.golden_dir + "/" + name, pixels, width,
+                             height);
+
+    std::sort(cpu_ms.begin(), cpu_ms.end());
+    float gpu_median, gpu_p95;
+    profiler.percentiles("frame", gpu_median, gpu_p95);
+    const size_t gpu_samples = profiler.sample_count("frame");
+    printf(
+        "{\"visual\":\"%s\",\"msaa\":%s,\"bloom\":%s,\"width\":%d,"
+        "\"height\":%d,\"frames\":%d,\"cpu_ms_median\":%.3f,"
+        "\"cpu_ms_p95\":%.3f,\"gpu_ms_median\":%.3f,\"gpu_ms_p95\":%.3f,"
+        "\"gpu_samples\":%zu,\"golden\":\"%s\"}\n",
+        visual_name.c_str(), msaa ? "true" : "false",
+        bloom ? "true" : "false", width, height, settings.frames,
+        cpu_ms[cpu_ms.size() / 2], cpu_ms[(cpu_ms.size() * 95) / 100],
+        gpu_median, gpu_p95, gpu_samples, golden);
+    fflush(stdout);
+
+    return std::string(golden) != "mismatch";
+}
+
+bool render_benchmark(const RenderBenchSettings &settings) {
+    const SyntheticAudioSource source(sample_rate, 4);
+    OffscreenContext context;
+
+    bool passed = true;
+    for (const char *visual : {"eclipse", "liquid", "scope", "waterfall"})
+        for (const bool msaa : {false, true})
+            for (const bool bloom : {false, true})
+                for (const auto &size : settings.sizes)
+                    passed &= run_case(source, visual, msaa, bloom, size.first,
+                                       size.second, settings, context);
+    return passed;
+}
@@ -0,0 +1,24 @@
+#ifndef RENDER_BENCHMARK_H
+#define RENDER_BENCHMARK_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct RenderBenchSettings {
+    std::vector<std::pair<int, int>> sizes = {
+        {640, 360}, {1280, 720}, {1920, 1080}};
+    int frames = 60;       // Timed frames per case
+    std::string dump_dir;  // Write the last frame of every case as PNG
+    std::string golden_dir;  // Compare the last frame against PNGs in here
+};
+
+// Render every visual with each combination of MSAA and bloom at each size in
+// a headless context, from a synthetic audio source at fixed positions so the
+// spectra are identical between runs. They are analysed once before the timed
+// frames, which only interpolate between them, so the frame times measure
+// rendering rather than the STFT. Prints one JSON object per case with CPU and
+// GPU frame times. Returns false if a golden frame did not match.
+bool render_benchmark(const RenderBenchSettings &settings);
+
+#endif /* RENDER_BENCHMARK_H */
@@ -0,0 +1,85 @@
+#include "render_target_pool.h"
+
+#include <cstdio>
+#include <iterator>  // next
+
+#include "gl_state.h"
+
+RenderTargetPool::RenderTargetPool(const size_t max_free)
+    : max_free_(max_free) {}
+
+RenderTargetPool::~RenderTargetPool() {
+    for (const RenderTarget& target : free_) destroy(target);
+}
+
+RenderTarget RenderTargetPool::acquire(const int width, const int height,
+                                       const int samples) {
+    // Most recently released first, it is the most likely to be warm
+    for (auto it = free_.rbegin(); it != free_.rend(); ++it) {
+        if (it->width == width && it->height == height &&
+            it->samples == samples) {
+            RenderTarget target = *it;
+            free_.erase(std::next(it).base());
+            return target;
+        }
+    }
+    return create(width, height, samples);
+}
+
+void RenderTargetPool::release(RenderTarget& target) {
+    if (target.framebuffer == 0) return;
+
+    free_.push_back(target);
+    target = RenderTarget();
+
+    if (free_.size() > max_free_) {
+        destroy(free_.front());
+        free_.erase(free_.begin());
+    }
+}
+
+RenderTarget RenderTargetPool::create(const int width, const int height,
+                                      const int samples) {
+    RenderTarget target;
+    target.width = width;
+    target.height = height;
+    target.samples = samples;
+
+    glGenTextures(1, &target.texture);
+    if (samples > 1) {
+        gl_state::bind_texture(GL_TEXTURE_2D_MULTISAMPLE, target.texture);
+        glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples,
+                                  GL_RGBA8, width, height, GL_FALSE);
+        gl_state::bind_texture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+    } else {
+        gl_state::bind_texture(GL_TEXTURE_2D, target.texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl_state::bind_texture(GL_TEXTURE_2D, 0);
+    }
+
+    const GLenum type =
+        (samples > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    glGenFramebuffers(1, &target.framebuffer);
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, type,
+                           target.texture, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        fprintf(stderr, "GL FrameBuffer %ix%i Error! %u\n", width, height,
+                status);
+    gl_state::bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+    return target;
+}
+
+void RenderTargetPool::destroy(const RenderTarget& target) {
+    gl_state::forget_framebuffer(target.framebuffer);
+    gl_state::forget_texture(target.texture);
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.texture);
+}
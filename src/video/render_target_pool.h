@@ -0,0 +1,42 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <GL/glew.h>
+
+#include <vector>
+
+// A colour texture together with a framebuffer rendering into it
+struct RenderTarget {
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    int samples = 1;  // > 1 for a GL_TEXTURE_2D_MULTISAMPLE texture
+};
+
+// Keeps released render targets around so that a later request of the same
+// size class (dimensions and sample count) reuses them instead of allocating.
+// Switching MSAA back and forth, or resizing to a previous size, then costs
+// no allocations. The least recently released targets are freed first once
+// more than max_free are idle.
+class RenderTargetPool {
+   public:
+    explicit RenderTargetPool(const size_t max_free = 16);
+    ~RenderTargetPool();
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    RenderTarget acquire(const int width, const int height,
+                         const int samples = 1);
+    void release(RenderTarget& target);
+
+   private:
+    const size_t max_free_;
+    std::vector<RenderTarget> free_;  // Oldest first
+
+    static RenderTarget create(const int width, const int height,
+                               const int samples);
+    static void destroy(const RenderTarget& target);
+};
+
+#endif /* RENDER_TARGET_POOL_H */
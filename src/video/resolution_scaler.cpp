@@ -0,0 +1,90 @@
+#include "resolution_scaler.h"
+
+#include <algorithm>  // max, min, nth_element
+#include <cmath>
+
+// Frames under this share of the budget may render at a larger scale
+static constexpr float headroom = 0.75f;
+
+// Scales are multiples of this, so that they repeat and pooled targets fit
+static constexpr float scale_step = 1.0f / 16;
+
+ResolutionScaler::ResolutionScaler() {
+    glGenQueries(2 * num_frames, &queries_[0][0]);
+}
+
+ResolutionScaler::~ResolutionScaler() {
+    glDeleteQueries(2 * num_frames, &queries_[0][0]);
+}
+
+void ResolutionScaler::set_budget(float milliseconds) {
+    budget_ms_ = std::max(0.0f, milliseconds);
+    scale_ = 1;
+    samples_.clear();
+}
+
+void ResolutionScaler::begin_frame() {
+    if (!enabled() || started_) return;
+    started_ = true;
+    glQueryCounter(queries_[frame_][0], GL_TIMESTAMP);
+}
+
+void ResolutionScaler::end_frame() {
+    if (!started_) return;
+    started_ = false;
+    glQueryCounter(queries_[frame_][1], GL_TIMESTAMP);
+    issued_[frame_] = true;
+
+    // Read back the slot issued num_frames ago before reusing it
+    frame_ = (frame_ + 1) % num_frames;
+    collect(frame_);
+    if (samples_.size() >= num_samples) adjust();
+}
+
+void ResolutionScaler::collect(int slot) {
+    if (!issued_[slot]) return;
+    issued_[slot] = false;
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(queries_[slot][1], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+    if (available != GL_TRUE) return;
+
+    GLuint64 begin = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(queries_[slot][0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(queries_[slot][1], GL_QUERY_RESULT, &end);
+    if (discard_ > 0) {
+        discard_--;
+    } else {
+        samples_.push_back((end - begin) * 1e-6f);
+    }
+}
+
+void ResolutionScaler::adjust() {
+    const size_t mid = samples_.size() / 2;
+    std::nth_element(samples_.begin(), samples_.begin() + mid,
+                     samples_.end());
+    const float frame_ms = std::max(samples_[mid], 1e-3f);
+    samples_.clear();
+
+    // Keep the scale while within budget, unless there is room to grow
+    const bool fits = frame_ms <= budget_ms_;
+    const bool room = frame_ms < headroom * budget_ms_ && scale_ < 1;
+    if (fits && !room) return;
+
+    // Cost follows the pixel count, i.e. the square of the scale. Aim a
+    // little below the budget so that the scale does not oscillate.
+    const float target = scale_ * std::sqrt(0.9f * budget_ms_ / frame_ms);
+    float rounded = std::round(target / scale_step) * scale_step;
+    if (!fits) {
+        // Rounding to the nearest step can land back on the current scale,
+        // which would stay over budget for good, so shrink by at least one
+        rounded = std::min(std::floor(target / scale_step) * scale_step,
+                           scale_ - scale_step);
+    }
+    const float scale = std::min(1.0f, std::max(min_scale, rounded));
+    if (scale == scale_) return;
+    scale_ = scale;
+    discard_ = num_frames;
+}
@@ -0,0 +1,50 @@
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include <GL/glew.h>
+
+#include <vector>
+
+// Chooses the render scale that keeps the GPU time of a frame within a budget.
+// Each frame is bracketed by GL_TIMESTAMP queries, which unlike the
+// GL_TIME_ELAPSED queries of GpuProfiler may overlap other timers. Results
+// are read back a few frames later without stalling, and the scale is only
+// changed after enough frames at the current one, in steps of 1/16, so that
+// render targets are not reallocated every frame.
+class ResolutionScaler {
+   public:
+    ResolutionScaler();
+    ~ResolutionScaler();
+    ResolutionScaler(const ResolutionScaler&) = delete;
+    ResolutionScaler& operator=(const ResolutionScaler&) = delete;
+
+    // GPU milliseconds per frame to stay within, 0 to stop scaling
+    void set_budget(float milliseconds);
+    bool enabled() const { return budget_ms_ > 0; }
+
+    // Share of the output size to render at
+    float scale() const { return scale_; }
+
+    void begin_frame();
+    void end_frame();
+
+   private:
+    static constexpr int num_frames = 4;        // Depth of the query ring
+    static constexpr size_t num_samples = 30;   // Frames per decision
+    static constexpr float min_scale = 0.25f;
+
+    GLuint queries_[num_frames][2];
+    bool issued_[num_frames] = {};
+    int frame_ = 0;
+    bool started_ = false;
+    int discard_ = 0;  // In-flight frames still rendered at the old scale
+
+    float budget_ms_ = 0;
+    float scale_ = 1;
+    std::vector<float> samples_;
+
+    void collect(int slot);
+    void adjust();
+};
+
+#endif /* RESOLUTION_SCALER_H */
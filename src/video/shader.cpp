@@ -3,8 +3,6 @@
 #include <sstream>
 #include <vector>
 
-static constexpr char GLSL_version[] = "#version 410 core\n";
-
 Shader::Shader(shader_types shader_type)
     : object_(glCreateShader(shader_type)) {}
 
@@ -35,6 +33,8 @@ void Shader::compile(const std::ifstream& shader_file) {
 
 void Shader::attach(GLuint program) { glAttachShader(program, object_); }
 
+void Shader::detach(GLuint program) { glDetachShader(program, object_); }
+
 bool Shader::ready() const {
     GLint compiled;
     glGetShaderiv(object_, GL_COMPILE_STATUS, &compiled);
@@ -6,6 +6,9 @@
 #include <fstream>
 #include <string>
 
+// Prepended to every shader source
+static constexpr char GLSL_version[] = "#version 410 core\n";
+
 enum shader_types { vertex = GL_VERTEX_SHADER, fragment = GL_FRAGMENT_SHADER };
 
 class Shader {
@@ -16,6 +19,7 @@ class Shader {
     void compile(const std::string& shader_source);
     void compile(const std::ifstream& shader_file);
     void attach(GLuint);
+    void detach(GLuint);
     bool ready() const;
 
    private:
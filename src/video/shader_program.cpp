@@ -1,74 +1,181 @@
 #include "shader_program.h"
 
+#include <algorithm>  // max
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <vector>
 
+#include "gl_state.h"
+#include "program_cache.h"
+
 ShaderProgram::ShaderProgram() : program(glCreateProgram()) {}
 
-ShaderProgram::~ShaderProgram() { glDeleteProgram(program); }
+ShaderProgram::~ShaderProgram() {
+    gl_state::forget_program(program);
+    glDeleteProgram(program);
+}
 
-void ShaderProgram::compile(const std::string &vertex_source,
-                            const std::string &fragment_source) {
-    vertex_shader.compile(vertex_source);
-    fragment_shader.compile(fragment_source);
+static std::string read_source(const std::ifstream &shader_file) {
+    if (!shader_file.is_open()) throw "Could not open shader file";
 
-    vertex_shader.attach(program);
-    fragment_shader.attach(program);
-
-    glLinkProgram(program);
+    std::ostringstream ss;
+    ss << shader_file.rdbuf();
+    return ss.str();
+}
 
-    if (!ready()) throw "Could not link shader program.\n" + get_messages();
+void ShaderProgram::compile(const std::string &vertex_source,
+                            const std::string &fragment_source) {
+    const uint64_t key = program_cache::key(vertex_source, fragment_source);
+
+    // Already linked from these sources, e.g. when a framebuffer reinitialises
+    if (linked_ && key == key_) return;
+
+    linked_ = false;
+    if (program_cache::load(key, program)) {
+        reflect();
+    } else {
+        vertex_shader.compile(vertex_source);
+        fragment_shader.compile(fragment_source);
+        link();
+        program_cache::store(key, program);
+    }
+    key_ = key;
+    linked_ = true;
 }
 
 void ShaderProgram::compile(const std::ifstream &vertex_file,
                             const std::ifstream &fragment_file) {
-    vertex_shader.compile(vertex_file);
-    fragment_shader.compile(fragment_file);
+    compile(read_source(vertex_file), read_source(fragment_file));
+}
 
+void ShaderProgram::link() {
     vertex_shader.attach(program);
     fragment_shader.attach(program);
 
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
 
-    if (!ready()) throw "Could not link shader program.\n" + get_messages();
+    // Detach so that the program can be relinked from other sources later
+    vertex_shader.detach(program);
+    fragment_shader.detach(program);
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+        throw "Could not link shader program.\n" + get_messages();
+
+    reflect();
 }
 
-bool ShaderProgram::ready() const {
-    GLint linked;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
-    return linked == GL_TRUE;
+void ShaderProgram::reflect() {
+    uniforms_.clear();
+    attributes_.clear();
+    blocks_.clear();
+
+    GLint count = 0;
+    GLint max_length = 0;
+    GLint size;
+    GLenum type;
+
+    // Uniforms in the default block (block members have no location)
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> name(std::max(max_length, 1));
+    for (GLint idx = 0; idx < count; idx++) {
+        glGetActiveUniform(program, idx, name.size(), NULL, &size, &type,
+                           name.data());
+        GLint location = glGetUniformLocation(program, name.data());
+        if (location < 0) continue;
+
+        // Arrays are reported as "name[0]"; allow lookup by the bare name
+        std::string key(name.data());
+        const size_t bracket = key.find("[0]");
+        if (bracket != std::string::npos) key.erase(bracket);
+        uniforms_[key] = location;
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+    name.resize(std::max(max_length, 1));
+    for (GLint idx = 0; idx < count; idx++) {
+        glGetActiveAttrib(program, idx, name.size(), NULL, &size, &type,
+                          name.data());
+        GLint location = glGetAttribLocation(program, name.data());
+        if (location >= 0) attributes_[name.data()] = location;
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                   &max_length);
+    name.resize(std::max(max_length, 1));
+    for (GLint idx = 0; idx < count; idx++) {
+        glGetActiveUniformBlockName(program, idx, name.size(), NULL,
+                                    name.data());
+        blocks_[name.data()] = idx;
+    }
 }
 
+// Link status is known from compile(), querying it would stall the pipeline
+bool ShaderProgram::ready() const { return linked_; }
+
 void ShaderProgram::use() const {
     if (!ready()) throw "Cannot use a shader program that isn't ready";
     VAO.bind();
-    glUseProgram(program);
+    gl_state::use_program(program);
+}
+
+UniformHandle ShaderProgram::uniform(const char *name) const {
+    UniformHandle handle;
+    auto it = uniforms_.find(name);
+    if (it != uniforms_.end()) handle.location = it->second;
+    return handle;
+}
+
+void ShaderProgram::set_uniform(UniformHandle uniform, int value) {
+    glProgramUniform1i(program, uniform.location, value);
+}
+
+void ShaderProgram::set_uniform(UniformHandle uniform, float value) {
+    glProgramUniform1f(program, uniform.location, value);
+}
+
+void ShaderProgram::set_uniform(UniformHandle uniform, float value1,
+                                float value2) {
+    glProgramUniform2f(program, uniform.location, value1, value2);
+}
+
+void ShaderProgram::set_uniform(UniformHandle uniform, float value1,
+                                float value2, float value3) {
+    glProgramUniform3f(program, uniform.location, value1, value2, value3);
 }
 
 void ShaderProgram::set_uniform(const char *name, int value) {
-    glUseProgram(program);
-    GLint uniform = glGetUniformLocation(program, name);
-    glUniform1i(uniform, value);
+    set_uniform(uniform(name), value);
 }
 
 void ShaderProgram::set_uniform(const char *name, float value) {
-    glUseProgram(program);
-    GLint uniform = glGetUniformLocation(program, name);
-    glUniform1f(uniform, value);
+    set_uniform(uniform(name), value);
 }
 
 void ShaderProgram::set_uniform(const char *name, float value1, float value2) {
-    glUseProgram(program);
-    GLint uniform = glGetUniformLocation(program, name);
-    glUniform2f(uniform, value1, value2);
+    set_uniform(uniform(name), value1, value2);
 }
 
 void ShaderProgram::set_uniform(const char *name, float value1, float value2,
                                 float value3) {
-    glUseProgram(program);
-    GLint uniform = glGetUniformLocation(program, name);
-    glUniform3f(uniform, value1, value2, value3);
+    set_uniform(uniform(name), value1, value2, value3);
+}
+
+void ShaderProgram::set_block(const char *name, GLuint binding) {
+    auto it = blocks_.find(name);
+    if (it == blocks_.end()) return;
+    glUniformBlockBinding(program, it->second, binding);
+}
+
+GLint ShaderProgram::attribute(const char *name) const {
+    auto it = attributes_.find(name);
+    return it == attributes_.end() ? -1 : it->second;
 }
 
 void ShaderProgram::set_attrib(const char *name) { set_attrib(name, 1, 0, 0); }
@@ -83,9 +190,9 @@ void ShaderProgram::set_attrib(const char *name, int N, size_t stride) {
 
 void ShaderProgram::set_attrib(const char *name, int N, size_t stride,
                                size_t offset) {
+    GLint attrib = attribute(name);
+    if (attrib < 0) return;
     VAO.bind();
-    glUseProgram(program);
-    GLint attrib = glGetAttribLocation(program, name);
     glEnableVertexAttribArray(attrib);
     glVertexAttribPointer(attrib, N, GL_FLOAT, GL_FALSE, stride,
                           (void *)offset);
@@ -93,15 +200,26 @@ void ShaderProgram::set_attrib(const char *name, int N, size_t stride,
 
 void ShaderProgram::set_input(const char *name,
                               const VertexBuffer &vertex_buffer) {
+    GLint attrib = attribute(name);
+    if (attrib < 0) return;
     VAO.bind();
     vertex_buffer.bind();
-    glUseProgram(program);
-    GLint attrib = glGetAttribLocation(program, name);
     glEnableVertexAttribArray(attrib);
     glVertexAttribPointer(attrib, 1, GL_FLOAT, GL_FALSE, sizeof(float),
                           (void *)0);
 }
 
+void ShaderProgram::set_input(const char *name,
+                              const StreamBuffer &stream_buffer) {
+    GLint attrib = attribute(name);
+    if (attrib < 0) return;
+    VAO.bind();
+    stream_buffer.bind();
+    glEnableVertexAttribArray(attrib);
+    glVertexAttribPointer(attrib, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+                          (void *)stream_buffer.offset());
+}
+
 std::string ShaderProgram::get_messages() {
     GLint maxLength = 0;
     glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
@@ -4,13 +4,21 @@
 #include <GL/glew.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <string>
+#include <unordered_map>
 
 #include "shader.h"
+#include "stream_buffer.h"
 #include "vertex_array.h"
 #include "vertex_buffer.h"
 
+// Location of an active uniform, resolved once when the program is linked
+struct UniformHandle {
+    GLint location = -1;
+};
+
 class ShaderProgram {
    public:
     ShaderProgram();
@@ -24,15 +32,24 @@ class ShaderProgram {
     bool ready() const;
     void use() const;
 
+    // Uniform values are written without making the program current
+    UniformHandle uniform(const char *name) const;
+    void set_uniform(UniformHandle, int);
+    void set_uniform(UniformHandle, float);
+    void set_uniform(UniformHandle, float, float);
+    void set_uniform(UniformHandle, float, float, float);
     void set_uniform(const char *, int);
     void set_uniform(const char *, float);
     void set_uniform(const char *, float, float);
     void set_uniform(const char *, float, float, float);
+    void set_block(const char *name, GLuint binding);
     void set_attrib(const char *, int N, size_t stride, size_t offset);
     void set_attrib(const char *, int N, size_t stride);
     void set_attrib(const char *, int N);
     void set_attrib(const char *);
     void set_input(const char *name, const VertexBuffer &vertex_buffer);
+    // Points the input at the region of the stream buffer last mapped
+    void set_input(const char *name, const StreamBuffer &stream_buffer);
 
    private:
     GLuint program;
@@ -40,6 +57,18 @@ class ShaderProgram {
     Shader fragment_shader = Shader(fragment);
     VertexArray VAO;
 
+    // Program cache key of the sources currently linked
+    uint64_t key_ = 0;
+    bool linked_ = false;
+
+    // Active interface, reflected at link time
+    std::unordered_map<std::string, GLint> uniforms_;
+    std::unordered_map<std::string, GLint> attributes_;
+    std::unordered_map<std::string, GLuint> blocks_;
+
+    void link();
+    void reflect();
+    GLint attribute(const char *name) const;
     std::string get_messages();
 };
 
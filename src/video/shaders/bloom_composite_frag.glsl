@@ -0,0 +1,14 @@
+R"(
+precision mediump float;
+
+uniform vec2      target_size;
+uniform sampler2D texture_sampler;
+
+out vec4 output_color;
+
+void main()
+{
+    // The first level is already smooth, a single bilinear tap suffices
+    output_color = texture(texture_sampler, gl_FragCoord.xy / target_size);
+
+})"
@@ -0,0 +1,23 @@
+R"(
+precision mediump float;
+
+uniform sampler2D texture_sampler;
+
+out vec4 output_color;
+
+void main()
+{
+    // Dual filter downsample: the centre plus four bilinear taps on the
+    // diagonals, each of which averages 2x2 source texels
+    vec2  texel       = 1.0 / vec2(textureSize(texture_sampler, 0));
+    vec2  uv          = 2.0 * gl_FragCoord.xy * texel;
+    vec4  total_color = texture(texture_sampler, uv) * 4.0;
+
+    total_color += texture(texture_sampler, uv + vec2(-texel.x, -texel.y)) +
+                   texture(texture_sampler, uv + vec2( texel.x, -texel.y)) +
+                   texture(texture_sampler, uv + vec2(-texel.x,  texel.y)) +
+                   texture(texture_sampler, uv + vec2( texel.x,  texel.y));
+
+    output_color = vec4(total_color.xyz / 8.0, 1.0);
+
+})"
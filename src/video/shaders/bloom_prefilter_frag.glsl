@@ -0,0 +1,23 @@
+R"(
+precision mediump float;
+
+uniform sampler2D texture_sampler;
+
+out vec4 output_color;
+
+void main()
+{
+    // Average the 2x2 source pixels under this pixel
+    ivec2 source    = 2 * ivec2(gl_FragCoord.xy);
+    ivec2 last      = textureSize(texture_sampler, 0) - 1;
+    vec4  total_color = vec4(0.0);
+
+    total_color += texelFetch(texture_sampler, min(source + ivec2(0, 0), last), 0) +
+                   texelFetch(texture_sampler, min(source + ivec2(1, 0), last), 0) +
+                   texelFetch(texture_sampler, min(source + ivec2(0, 1), last), 0) +
+                   texelFetch(texture_sampler, min(source + ivec2(1, 1), last), 0);
+    total_color /= 4.0;
+
+    output_color = vec4(total_color.xyz, 1.0);
+
+})"
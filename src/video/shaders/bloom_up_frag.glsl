@@ -0,0 +1,24 @@
+R"(
+precision mediump float;
+
+uniform vec2      target_size;
+uniform sampler2D texture_sampler;
+
+out vec4 output_color;
+
+void main()
+{
+    // Tent upsample of the lower resolution level: four bilinear taps on the
+    // diagonals, each of which averages 2x2 source texels
+    vec2  texel       = 1.0 / vec2(textureSize(texture_sampler, 0));
+    vec2  uv          = gl_FragCoord.xy / target_size;
+    vec4  total_color = vec4(0.0);
+
+    total_color += texture(texture_sampler, uv + vec2(-texel.x, -texel.y)) +
+                   texture(texture_sampler, uv + vec2( texel.x, -texel.y)) +
+                   texture(texture_sampler, uv + vec2(-texel.x,  texel.y)) +
+                   texture(texture_sampler, uv + vec2( texel.x,  texel.y));
+
+    output_color = vec4(total_color.xyz / 4.0, 1.0);
+
+})"
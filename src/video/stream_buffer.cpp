@@ -0,0 +1,76 @@
+#include "stream_buffer.h"
+
+#include <cstdint>
+
+StreamBuffer::StreamBuffer(const unsigned long size)
+    : size_(size),
+      persistent_(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage),
+      fences_(num_regions, nullptr) {
+    glGenBuffers(1, &VBO_);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+
+    if (persistent_) {
+        // Keep regions aligned for the mapping and vertex fetch
+        region_size_ = (size_ * sizeof(GLfloat) + 255) / 256 * 256;
+
+        const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const std::vector<char> zeros(num_regions * region_size_, 0);
+        glBufferStorage(GL_ARRAY_BUFFER, zeros.size(), zeros.data(), flags);
+        mapped_ = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, zeros.size(),
+                                           flags);
+        current_ = num_regions - 1;
+    } else {
+        region_size_ = 0;
+        glBufferData(GL_ARRAY_BUFFER, size_ * sizeof(GLfloat), NULL,
+                     GL_STREAM_DRAW);
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync fence : fences_)
+        if (fence) glDeleteSync(fence);
+    if (persistent_) {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glDeleteBuffers(1, &VBO_);
+}
+
+void StreamBuffer::bind() const { glBindBuffer(GL_ARRAY_BUFFER, VBO_); }
+
+float* StreamBuffer::map() {
+    if (!persistent_) {
+        // Orphan the old storage so that pending draws keep reading from it
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+        glBufferData(GL_ARRAY_BUFFER, size_ * sizeof(GLfloat), NULL,
+                     GL_STREAM_DRAW);
+        return (float*)glMapBufferRange(
+            GL_ARRAY_BUFFER, 0, size_ * sizeof(GLfloat),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    // Fence the region drawn last, its draws have been submitted by now
+    if (fences_[current_]) glDeleteSync(fences_[current_]);
+    fences_[current_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // Wait until the GPU has finished with the oldest region
+    current_ = (current_ + 1) % num_regions;
+    if (GLsync fence = fences_[current_]) {
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(fence, flags, UINT64_MAX) ==
+               GL_TIMEOUT_EXPIRED)
+            flags = 0;
+        glDeleteSync(fence);
+        fences_[current_] = nullptr;
+    }
+
+    return (float*)((char*)mapped_ + offset());
+}
+
+void StreamBuffer::unmap() {
+    if (!persistent_) {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+}
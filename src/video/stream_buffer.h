@@ -0,0 +1,41 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <GL/glew.h>
+
+#include <vector>
+
+// Vertex buffer rewritten completely every frame. With ARB_buffer_storage the
+// buffer holds several regions that stay persistently mapped, and each region
+// is fenced so that it is only rewritten once the GPU has finished reading
+// it. Otherwise the buffer is orphaned and mapped again each frame.
+class StreamBuffer {
+   public:
+    explicit StreamBuffer(const unsigned long size);
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Region for the next frame; all size() floats must be written before
+    // unmap(). Drawing from the previous region must have been submitted.
+    float* map();
+    void unmap();
+
+    void bind() const;
+    unsigned long size() const { return size_; };
+    // Byte offset of the region last returned by map()
+    size_t offset() const { return current_ * region_size_; }
+
+   private:
+    static constexpr int num_regions = 3;
+
+    GLuint VBO_;
+    const unsigned long size_;
+    size_t region_size_;
+    bool persistent_;
+    float* mapped_ = nullptr;
+    int current_ = 0;
+    std::vector<GLsync> fences_;
+};
+
+#endif /* STREAM_BUFFER_H */
@@ -0,0 +1,73 @@
+#include "track_buffer.h"
+
+#include <algorithm>  // max, min
+#include <stdexcept>
+#include <vector>
+
+#include "gl_state.h"
+
+TrackBuffer::TrackBuffer(const IAudioSource &audio_source)
+    : num_samples_(audio_source.num_samples()) {
+    GLint max_size = 0;
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+
+    // Short tracks get a single layer no larger than they need
+    const unsigned long samples = std::max(1ul, num_samples_);
+    row_length_ = std::min(max_row_length, max_size);
+    const unsigned long rows = (samples + row_length_ - 1) / row_length_;
+    rows_per_layer_ = (int)std::min<unsigned long>(rows, max_size);
+    const unsigned long num_layers =
+        (rows + rows_per_layer_ - 1) / rows_per_layer_;
+    if (num_layers > (unsigned long)max_layers)
+        throw std::runtime_error("Track too long for a GPU texture");
+
+    glGenTextures(1, &texture_);
+    gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, texture_);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RG16F, row_length_,
+                   rows_per_layer_, num_layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Repack to stereo a chunk of rows at a time, zero after the last sample
+    const std::vector<float> &data = audio_source.data();
+    const unsigned long num_channels = audio_source.num_channels();
+    const unsigned long right = num_channels > 1 ? 1 : 0;
+    std::vector<float> chunk(2 * rows_per_chunk * row_length_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (unsigned long row = 0; row < rows && num_channels > 0;) {
+        // Chunks never cross a layer
+        const unsigned long layer = row / rows_per_layer_;
+        const unsigned long layer_row = row % rows_per_layer_;
+        const unsigned long chunk_rows = std::min<unsigned long>(
+            {(unsigned long)rows_per_chunk, rows - row,
+             rows_per_layer_ - layer_row});
+
+        const unsigned long first = row * row_length_;
+        const unsigned long count =
+            std::min(chunk_rows * row_length_, num_samples_ - first);
+        for (unsigned long idx = 0; idx < count; idx++) {
+            const float *frame = &data[(first + idx) * num_channels];
+            chunk[2 * idx] = frame[0];
+            chunk[2 * idx + 1] = frame[right];
+        }
+        std::fill(chunk.begin() + 2 * count,
+                  chunk.begin() + 2 * chunk_rows * row_length_, 0.0f);
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, layer_row, layer,
+                        row_length_, chunk_rows, 1, GL_RG, GL_FLOAT,
+                        chunk.data());
+        row += chunk_rows;
+    }
+    gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TrackBuffer::~TrackBuffer() {
+    gl_state::forget_texture(texture_);
+    glDeleteTextures(1, &texture_);
+}
+
+void TrackBuffer::bind() const {
+    gl_state::bind_texture(GL_TEXTURE_2D_ARRAY, texture_);
+}
@@ -0,0 +1,43 @@
+#ifndef TRACK_BUFFER_H
+#define TRACK_BUFFER_H
+
+#include <GL/glew.h>
+
+#include "audio/i_source.h"
+
+// The whole decoded track in a texture, uploaded once so that time-domain
+// visuals read samples on the GPU and only pass a sample offset per frame.
+//
+// Sample n of the left and right channel is the RG texel
+//   layer = n / layer_size, row = n % layer_size / row_length,
+//   column = n % row_length
+// of a 2D array texture, so tracks longer than the largest 2D texture still
+// fit. Mono tracks are stored on both sides. Values are half floats, plenty
+// for drawing at half the memory.
+class TrackBuffer {
+   public:
+    explicit TrackBuffer(const IAudioSource &audio_source);
+    ~TrackBuffer();
+    TrackBuffer(const TrackBuffer &) = delete;
+    TrackBuffer &operator=(const TrackBuffer &) = delete;
+
+    // Bind the texture to unit 0, for a sampler2DArray
+    void bind() const;
+
+    unsigned long num_samples() const { return num_samples_; }
+    int row_length() const { return row_length_; }
+    int layer_size() const { return row_length_ * rows_per_layer_; }
+
+   private:
+    static constexpr int max_row_length = 4096;
+
+    // Rows uploaded per call, bounds the staging copy for long tracks
+    static constexpr int rows_per_chunk = 64;
+
+    GLuint texture_;
+    const unsigned long num_samples_;
+    int row_length_;
+    int rows_per_layer_;
+};
+
+#endif /* TRACK_BUFFER_H */
@@ -0,0 +1,64 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <GL/glew.h>
+
+// Uniform buffer holding a single std140 block of type T. Changes are
+// staged on the CPU and uploaded at most once when the buffer is bound.
+template <typename T>
+class UniformBuffer {
+   public:
+    UniformBuffer() {
+        glGenBuffers(1, &UBO_);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO_);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    ~UniformBuffer() { glDeleteBuffers(1, &UBO_); }
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Mutable access marks the block for upload on the next bind()
+    T& data() {
+        dirty_ = true;
+        return data_;
+    }
+    const T& data() const { return data_; }
+
+    void bind() const {
+        if (dirty_) {
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO_);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data_);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            dirty_ = false;
+        }
+        glBindBufferBase(GL_UNIFORM_BUFFER, T::binding, UBO_);
+    }
+
+   private:
+    // std140 blocks are sized in multiples of a vec4
+    static constexpr GLsizeiptr size = (sizeof(T) + 15) / 16 * 16;
+
+    GLuint UBO_;
+    T data_ = T();
+    mutable bool dirty_ = true;
+};
+
+// Parameters common to every visual's shaders, laid out as the std140 block
+//
+//     layout(std140) uniform SharedParams {
+//         vec2 resolution;
+//         int num_freq;
+//         int min_note;
+//         int max_note;
+//     };
+struct SharedParams {
+    static constexpr GLuint binding = 0;
+
+    alignas(8) float resolution[2];
+    int num_freq;
+    int min_note;
+    int max_note;
+};
+
+#endif /* UNIFORM_BUFFER_H */
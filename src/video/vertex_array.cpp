@@ -2,6 +2,8 @@
 
 #include <GL/glew.h>
 
+#include "gl_state.h"
+
 static GLuint create() {
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
@@ -10,6 +12,9 @@ static GLuint create() {
 
 VertexArray::VertexArray() : VAO_(create()) {}
 
-VertexArray::~VertexArray() { glDeleteVertexArrays(1, &VAO_); }
+VertexArray::~VertexArray() {
+    gl_state::forget_vertex_array(VAO_);
+    glDeleteVertexArrays(1, &VAO_);
+}
 
-void VertexArray::bind() const { glBindVertexArray(VAO_); }
+void VertexArray::bind() const { gl_state::bind_vertex_array(VAO_); }
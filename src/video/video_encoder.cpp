@@ -0,0 +1,375 @@
+#include "video_encoder.h"
+
+#include <algorithm>  // min, max
+#include <sstream>
+#include <vector>
+
+VideoEncoder::VideoEncoder(const std::string &filename, const int width,
+                           const int height, const int fps,
+                           const IAudioSource *audio)
+    : audio_(audio), width_(width), height_(height), fps_(fps) {
+    try {
+        open(filename);
+        open_video();
+        if (audio_) open_audio();
+        start(filename);
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+VideoEncoder::VideoEncoder(const std::string &filename,
+                           const AVCodecParameters *video_parameters,
+                           const int fps, const IAudioSource *audio)
+    : audio_(audio),
+      width_(video_parameters->width),
+      height_(video_parameters->height),
+      fps_(fps) {
+    try {
+        open(filename);
+        copy_video(video_parameters);
+        if (audio_) open_audio();
+        start(filename);
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+VideoEncoder::~VideoEncoder() {
+    if (!finished_) {
+        try {
+            finish();
+        } catch (const VideoEncoderError &) {
+        }
+    }
+    close();
+}
+
+void VideoEncoder::close() {
+    av_packet_free(&packet);
+    av_frame_free(&audio_frame);
+    av_frame_free(&video_frame);
+
+    swr_free(&swr);
+    sws_freeContext(sws);
+    sws = nullptr;
+
+    avcodec_free_context(&audio_context);
+    avcodec_free_context(&video_context);
+
+    if (format && !(format->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&format->pb);
+    avformat_free_context(format);
+    format = nullptr;
+}
+
+void VideoEncoder::open(const std::string &filename) {
+    // Pick the container from the file extension
+    int status =
+        avformat_alloc_output_context2(&format, NULL, NULL, filename.c_str());
+    if (status < 0)
+        throw VideoEncoderError(status, "avformat_alloc_output_context2",
+                                "Unknown output format");
+    packet = av_packet_alloc();
+}
+
+void VideoEncoder::start(const std::string &filename) {
+    int status;
+
+    // Open file
+    if (!(format->oformat->flags & AVFMT_NOFILE)) {
+        status = avio_open(&format->pb, filename.c_str(), AVIO_FLAG_WRITE);
+        if (status < 0) throw VideoEncoderError(status, "avio_open", "");
+    }
+
+    status = avformat_write_header(format, NULL);
+    if (status < 0)
+        throw VideoEncoderError(status, "avformat_write_header", "");
+}
+
+void VideoEncoder::open_video() {
+    int status;
+
+    const AVCodec *codec = avcodec_find_encoder(format->oformat->video_codec);
+    if (codec == NULL)
+        throw VideoEncoderError(AVERROR_ENCODER_NOT_FOUND,
+                                "avcodec_find_encoder", "No video encoder");
+
+    video_stream = avformat_new_stream(format, NULL);
+    video_context = avcodec_alloc_context3(codec);
+    video_context->width = width_;
+    video_context->height = height_;
+    video_context->time_base = AVRational{1, fps_};
+    video_context->framerate = AVRational{fps_, 1};
+    video_context->gop_size = 2 * fps_;
+    video_context->pix_fmt =
+        codec->pix_fmts ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+
+    // Constant quality where the encoder supports it (x264/x265), otherwise
+    // a bitrate generous enough for thin bright lines
+    if (video_context->priv_data == NULL ||
+        av_opt_set(video_context->priv_data, "crf", "18", 0) < 0)
+        video_context->bit_rate = (int64_t)width_ * height_ * fps_ / 4;
+
+    if (format->oformat->flags & AVFMT_GLOBALHEADER)
+        video_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    status = avcodec_open2(video_context, codec, NULL);
+    if (status < 0) throw VideoEncoderError(status, "avcodec_open2", "video");
+
+    avcodec_parameters_from_context(video_stream->codecpar, video_context);
+    video_stream->time_base = video_context->time_base;
+
+    video_frame = av_frame_alloc();
+    video_frame->format = video_context->pix_fmt;
+    video_frame->width = width_;
+    video_frame->height = height_;
+    status = av_frame_get_buffer(video_frame, 0);
+    if (status < 0) throw VideoEncoderError(status, "av_frame_get_buffer", "");
+
+    // prepare colour conversion
+    sws = sws_getContext(width_, height_, AV_PIX_FMT_RGBA, width_, height_,
+                         video_context->pix_fmt, SWS_BILINEAR, NULL, NULL,
+                         NULL);
+    if (sws == NULL)
+        throw VideoEncoderError(-1, "sws_getContext",
+                                "Scaler couldn't be initialized");
+}
+
+void VideoEncoder::copy_video(const AVCodecParameters *video_parameters) {
+    video_stream = avformat_new_stream(format, NULL);
+    int status =
+        avcodec_parameters_copy(video_stream->codecpar, video_parameters);
+    if (status < 0)
+        throw VideoEncoderError(status, "avcodec_parameters_copy", "");
+    video_stream->codecpar->codec_tag = 0;
+    video_stream->time_base = AVRational{1, fps_};
+}
+
+void VideoEncoder::open_audio() {
+    int status;
+
+    const AVCodec *codec = avcodec_find_encoder(format->oformat->audio_codec);
+    if (codec == NULL)
+        throw VideoEncoderError(AVERROR_ENCODER_NOT_FOUND,
+                                "avcodec_find_encoder", "No audio encoder");
+
+    const int channels = audio_->num_channels();
+    const int sample_rate = audio_->sample_rate();
+    const int64_t channel_layout = av_get_default_channel_layout(channels);
+
+    audio_stream = avformat_new_stream(format, NULL);
+    audio_context = avcodec_alloc_context3(codec);
+    audio_context->sample_fmt =
+        codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+    audio_context->sample_rate = sample_rate;
+    audio_context->channels = channels;
+    audio_context->channel_layout = channel_layout;
+    audio_context->bit_rate = 320000;
+    audio_context->time_base = AVRational{1, sample_rate};
+
+    if (format->oformat->flags & AVFMT_GLOBALHEADER)
+        audio_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    status = avcodec_open2(audio_context, codec, NULL);
+    if (status < 0) throw VideoEncoderError(status, "avcodec_open2", "audio");
+
+    avcodec_parameters_from_context(audio_stream->codecpar, audio_context);
+    audio_stream->time_base = audio_context->time_base;
+
+    int frame_size = audio_context->frame_size;
+    if (frame_size == 0 ||
+        (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+        frame_size = 1024;
+
+    audio_frame = av_frame_alloc();
+    audio_frame->format = audio_context->sample_fmt;
+    audio_frame->channel_layout = channel_layout;
+    audio_frame->sample_rate = sample_rate;
+    audio_frame->nb_samples = frame_size;
+    status = av_frame_get_buffer(audio_frame, 0);
+    if (status < 0) throw VideoEncoderError(status, "av_frame_get_buffer", "");
+
+    // prepare sample format conversion from the interleaved float source
+    swr = swr_alloc_set_opts(NULL, channel_layout, audio_context->sample_fmt,
+                             sample_rate, channel_layout, AV_SAMPLE_FMT_FLT,
+                             sample_rate, 0, NULL);
+    swr_init(swr);
+    if (!swr_is_initialized(swr))
+        throw VideoEncoderError(-1, "swr_init",
+                                "Resampler couldn't be initialized");
+}
+
+void VideoEncoder::write_frame(const unsigned char *rgba) {
+    int status = av_frame_make_writable(video_frame);
+    if (status < 0)
+        throw VideoEncoderError(status, "av_frame_make_writable", "");
+
+    // Flip vertically by starting at the last row with a negative stride
+    const uint8_t *rows[1] = {rgba + 4 * width_ * (height_ - 1)};
+    const int strides[1] = {-4 * width_};
+    sws_scale(sws, rows, strides, 0, height_, video_frame->data,
+              video_frame->linesize);
+
+    video_frame->pts = frame_count_++;
+    send(video_context, video_stream, video_frame);
+
+    // Keep the audio interleaved with the video written so far
+    if (audio_) write_audio(frame_count_ * audio_->sample_rate() / fps_);
+}
+
+void VideoEncoder::append(const std::string &segment,
+                          const unsigned long first_frame) {
+    AVFormatContext *input = NULL;
+    int status = avformat_open_input(&input, segment.c_str(), NULL, NULL);
+    if (status != 0)
+        throw VideoEncoderError(status, "avformat_open_input", segment);
+
+    const AVRational frame_base = AVRational{1, fps_};
+    try {
+        while (av_read_frame(input, packet) >= 0) {
+            const AVStream *stream = input->streams[packet->stream_index];
+            if (stream->codecpar->codec_type != AVMEDIA_TYPE_VIDEO) {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            // Timestamps count frames from the start of the segment
+            av_packet_rescale_ts(packet, stream->time_base, frame_base);
+            if (packet->pts != AV_NOPTS_VALUE) packet->pts += first_frame;
+            if (packet->dts != AV_NOPTS_VALUE) packet->dts += first_frame;
+            if (packet->pts != AV_NOPTS_VALUE)
+                frame_count_ = std::max(frame_count_,
+                                        (unsigned long)packet->pts + 1);
+
+            av_packet_rescale_ts(packet, frame_base, video_stream->time_base);
+            packet->stream_index = video_stream->index;
+            packet->pos = -1;
+            status = av_interleaved_write_frame(format, packet);
+            if (status < 0)
+                throw VideoEncoderError(status, "av_interleaved_write_frame",
+                                        "");
+
+            if (audio_)
+                write_audio(frame_count_ * audio_->sample_rate() / fps_);
+        }
+    } catch (...) {
+        avformat_close_input(&input);
+        throw;
+    }
+    avformat_close_input(&input);
+}
+
+void VideoEncoder::write_audio(const unsigned long until_sample) {
+    const unsigned long channels = audio_->num_channels();
+    const unsigned long num_samples = audio_->num_samples();
+    const unsigned long frame_size = audio_frame->nb_samples;
+
+    std::vector<float> padded;
+    while (audio_position_ < num_samples &&
+           audio_position_ + frame_size <= until_sample) {
+        const float *input = audio_->data().data() + channels * audio_position_;
+
+        // Pad the final frame with silence
+        const unsigned long available = num_samples - audio_position_;
+        if (available < frame_size) {
+            padded.assign(channels * frame_size, 0);
+            std::copy(input, input + channels * available, padded.begin());
+            input = padded.data();
+        }
+
+        int status = av_frame_make_writable(audio_frame);
+        if (status < 0)
+            throw VideoEncoderError(status, "av_frame_make_writable", "");
+
+        const uint8_t *in[1] = {(const uint8_t *)input};
+        status =
+            swr_convert(swr, audio_frame->data, frame_size, in, frame_size);
+        if (status < 0)
+            throw VideoEncoderError(status, "swr_convert", "Resample error");
+
+        audio_frame->pts = audio_position_;
+        send(audio_context, audio_stream, audio_frame);
+        audio_position_ += frame_size;
+    }
+}
+
+void VideoEncoder::send(AVCodecContext *context, AVStream *stream,
+                        AVFrame *frame) {
+    int status = avcodec_send_frame(context, frame);
+    if (status < 0)
+        throw VideoEncoderError(status, "avcodec_send_frame", "Encode error");
+
+    while (true) {
+        status = avcodec_receive_packet(context, packet);
+        if (status == AVERROR(EAGAIN) || status == AVERROR_EOF) break;
+        if (status < 0)
+            throw VideoEncoderError(status, "avcodec_receive_packet",
+                                    "Packet error");
+
+        av_packet_rescale_ts(packet, context->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        status = av_interleaved_write_frame(format, packet);
+        if (status < 0)
+            throw VideoEncoderError(status, "av_interleaved_write_frame", "");
+    }
+}
+
+void VideoEncoder::finish() {
+    if (finished_) return;
+    finished_ = true;
+
+    // Remaining audio, then drain both encoders
+    if (audio_) {
+        write_audio(audio_->num_samples() + audio_frame->nb_samples);
+        send(audio_context, audio_stream, NULL);
+    }
+    if (video_context) send(video_context, video_stream, NULL);
+
+    int status = av_write_trailer(format);
+    if (status < 0) throw VideoEncoderError(status, "av_write_trailer", "");
+}
+
+void concatenate_segments(const std::vector<std::string> &segments,
+                          const std::vector<unsigned long> &first_frames,
+                          const std::string &filename, const int fps,
+                          const IAudioSource &audio) {
+    // All segments share the codec parameters of the first one
+    AVFormatContext *input = NULL;
+    int status = avformat_open_input(&input, segments[0].c_str(), NULL, NULL);
+    if (status != 0)
+        throw VideoEncoderError(status, "avformat_open_input", segments[0]);
+    status = avformat_find_stream_info(input, NULL);
+    if (status < 0 || input->nb_streams == 0) {
+        avformat_close_input(&input);
+        throw VideoEncoderError(status, "avformat_find_stream_info",
+                                segments[0]);
+    }
+
+    AVCodecParameters *parameters = avcodec_parameters_alloc();
+    avcodec_parameters_copy(parameters, input->streams[0]->codecpar);
+    avformat_close_input(&input);
+
+    try {
+        VideoEncoder encoder(filename, parameters, fps, &audio);
+        for (unsigned long idx = 0; idx < segments.size(); idx++)
+            encoder.append(segments[idx], first_frames[idx]);
+        encoder.finish();
+    } catch (...) {
+        avcodec_parameters_free(&parameters);
+        throw;
+    }
+    avcodec_parameters_free(&parameters);
+}
+
+VideoEncoderError::VideoEncoderError(int error_code,
+                                     const std::string &error_source,
+                                     std::string info) {
+    std::ostringstream os;
+    os << "Failed to encode video due to error ";
+    os << std::to_string(error_code) << " returned by " << error_source;
+    if (!info.empty()) os << " (" << info << ")";
+    message = os.str();
+}
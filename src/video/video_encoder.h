@@ -0,0 +1,94 @@
+#ifndef VIDEO_ENCODER_H
+#define VIDEO_ENCODER_H
+
+#include <string>
+#include <vector>
+
+#include "audio/i_source.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+}
+
+// Encodes rendered RGBA frames into a video file alongside the audio of the
+// source, using the container's default video and audio codecs. Without an
+// audio source only the video stream is written.
+class VideoEncoder {
+   public:
+    VideoEncoder(const std::string &filename, const int width,
+                 const int height, const int fps, const IAudioSource *audio);
+
+    // Mux already encoded video, described by the given parameters and
+    // supplied through append(), with newly encoded audio
+    VideoEncoder(const std::string &filename,
+                 const AVCodecParameters *video_parameters, const int fps,
+                 const IAudioSource *audio);
+    ~VideoEncoder();
+    VideoEncoder(const VideoEncoder &) = delete;
+    VideoEncoder &operator=(const VideoEncoder &) = delete;
+
+    // Encode one frame of bottom-up RGBA rows, as returned by glReadPixels
+    void write_frame(const unsigned char *rgba);
+
+    // Copy every video packet of a file written by another VideoEncoder,
+    // shifted to start at the given frame
+    void append(const std::string &segment, const unsigned long first_frame);
+
+    // Encode the remaining audio, flush the encoders and close the file
+    void finish();
+
+    unsigned long frame_count() const { return frame_count_; }
+
+   private:
+    const IAudioSource *audio_;
+    const int width_;
+    const int height_;
+    const int fps_;
+    bool finished_ = false;
+
+    unsigned long frame_count_ = 0;
+    unsigned long audio_position_ = 0;
+
+    AVFormatContext *format = nullptr;
+    AVCodecContext *video_context = nullptr;
+    AVCodecContext *audio_context = nullptr;
+    AVStream *video_stream = nullptr;
+    AVStream *audio_stream = nullptr;
+    SwsContext *sws = nullptr;
+    SwrContext *swr = nullptr;
+    AVFrame *video_frame = nullptr;
+    AVFrame *audio_frame = nullptr;
+    AVPacket *packet = nullptr;
+
+    void open(const std::string &filename);
+    void start(const std::string &filename);
+    void close();
+    void open_video();
+    void copy_video(const AVCodecParameters *video_parameters);
+    void open_audio();
+    void write_audio(const unsigned long until_sample);
+    void send(AVCodecContext *context, AVStream *stream, AVFrame *frame);
+};
+
+// Join video-only segments, each starting at the matching first frame, into
+// one file together with the audio source
+void concatenate_segments(const std::vector<std::string> &segments,
+                          const std::vector<unsigned long> &first_frames,
+                          const std::string &filename, const int fps,
+                          const IAudioSource &audio);
+
+class VideoEncoderError : virtual public std::exception {
+   public:
+    VideoEncoderError(int error_code, const std::string &error_source,
+                      std::string info);
+    const char *what() const throw() { return message.c_str(); }
+
+   protected:
+    std::string message;
+};
+
+#endif /* VIDEO_ENCODER_H */
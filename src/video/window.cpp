@@ -1,5 +1,7 @@
 #include "window.h"
 
+#include "gl_state.h"
+
 GLboolean glewExperimental = GL_TRUE;
 
 Window::Window() {
@@ -30,7 +32,8 @@ Window::Window() {
     }
 
     SDL_GL_SetSwapInterval(0);
-    glViewport(0, 0, 640, 480);
+    gl_state::invalidate();
+    gl_state::viewport(0, 0, 640, 480);
 
     printf("Vendor:   %s\n", glGetString(GL_VENDOR));
     printf("Renderer: %s\n", glGetString(GL_RENDERER));
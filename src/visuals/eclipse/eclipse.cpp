@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include "algorithm/note_stft.h"
+
 static const char* src_shader_vertex =
 #include "visuals/eclipse/vertex.glsl"
     ;
@@ -9,79 +11,45 @@ static const char* src_shader_fragment =
 #include "visuals/eclipse/fragment.glsl"
     ;
 
-static constexpr unsigned long segment_length = 16384;
-static constexpr unsigned long window_length = segment_length;
-static constexpr unsigned long window_overlap = 0;
-static constexpr unsigned long transform_length = 4 * window_length;
-
-static STFT create_stft(const IAudioSource& audio_source) {
-    SpectrogramInput props;
-    props.data_size = sizeof(float);
-    props.sample_rate = audio_source.sample_rate();
-    props.num_samples = segment_length;
-    props.stride = 1;  // Not equal to # of channels since we deinterleave first
-
-    SpectrogramConfig config;
-    config.padding_mode = PAD;
-    config.window_length = window_length;
-    config.window_overlap = window_overlap;
-    config.transform_length = transform_length;
-    config.window_type = HAMMING;
-
-    return STFT(props, config);
-}
-
 EclipseVisual::EclipseVisual(const IAudioSource& audio_source,
-                             const FrameBuffer& fb)
+                             FrameBuffer& fb)
     : audio_source_(audio_source),
-      stft_(create_stft(audio_source)),
+      stft_(create_note_stft(audio_source.sample_rate())),
+      analyzer_(audio_source, stft_),
       fb_(fb),
-      vertex_buffer_(VertexBuffer(2 * stft_.length())) {
-    // Set data parameters and allocate
+      vertex_buffer_(2 * stft_.length()) {
+    // Set data parameters
     num_vertices_ = 2 * stft_.length();
-    vertices_.resize(num_vertices_);
 
     // Compile and link shader
     program_.compile(src_shader_vertex, src_shader_fragment);
 
-    // Set uniforms and array
-    program_.set_uniform("num_freq", (int)stft_.length());
-    program_.set_uniform("min_note", -50);
-    program_.set_uniform("max_note", 50);
-    program_.set_uniform("resolution", (float)fb_.width(), (float)fb_.height());
-    program_.set_input("amplitude", vertex_buffer_);
+    // Set shared parameters and array
+    SharedParams& params = fb_.shared_params();
+    params.num_freq = (int)stft_.length();
+    params.min_note = note_stft::min_note;
+    params.max_note = note_stft::max_note;
+    program_.set_block("SharedParams", SharedParams::binding);
 }
 
 void EclipseVisual::draw(const unsigned long position) {
-    // Get signal at current position
-    const unsigned long center = position - segment_length / 2;
-    std::vector<float> signal_left =
-        audio_source_.get_segment(0, center, segment_length);
-    std::vector<float> signal_right =
-        audio_source_.get_segment(1, center, segment_length);
-
-    // Must check size since get_window can return a shorter vector than
-    // requested
-    if (signal_left.size() == segment_length &&
-        signal_right.size() == segment_length) {
-        // Compute spectrum
-        std::vector<float> power_left = stft_.compute(signal_left);
-        std::vector<float> power_right = stft_.compute(signal_right);
-
-        // Arrange spectra in vertex array
-        for (unsigned long idx = 0; idx < stft_.length(); idx++)
-            vertices_[idx] = power_left[idx];
-        for (unsigned long idx = 0; idx < stft_.length(); idx++)
-            vertices_[num_vertices_ - idx - 1] = power_right[idx];
-
-    } else {
-        // Clear out vertex array
-        for (unsigned long idx = 0; idx < vertices_.size(); idx++)
-            vertices_[idx] = 0;
-    }
+    // Get spectra at current position
+    analyzer_.update(position);
+    const std::vector<float>& power_left = analyzer_.left();
+    const std::vector<float>& power_right = analyzer_.right();
+
+    // Write straight into this frame's region of the vertex buffer
+    float* vertices = vertex_buffer_.map();
+
+    // Arrange spectra in vertex array
+    for (unsigned long idx = 0; idx < stft_.length(); idx++)
+        vertices[idx] = power_left[idx];
+    for (unsigned long idx = 0; idx < stft_.length(); idx++)
+        vertices[num_vertices_ - idx - 1] = power_right[idx];
 
     // Update the data
-    vertex_buffer_.push(vertices_.data());
+    vertex_buffer_.unmap();
+    program_.set_input("amplitude", vertex_buffer_);
 
     // Draw
     fb_.bind();
@@ -93,9 +61,22 @@ void EclipseVisual::draw(const unsigned long position) {
 std::string EclipseVisual::name() { return std::string("Eclipse"); }
 
 void EclipseVisual::set_resolution(const float width, const float height) {
-    program_.set_uniform("resolution", width, height);
+    fb_.shared_params().resolution[0] = width;
+    fb_.shared_params().resolution[1] = height;
 }
 
 void EclipseVisual::set_resolution(const int width, const int height) {
-    program_.set_uniform("resolution", (float)width, (float)height);
+    set_resolution((float)width, (float)height);
+}
+
+void EclipseVisual::set_analysis_rate(const double rate) {
+    analyzer_.set_rate(rate);
+}
+
+void EclipseVisual::set_spectrum_publisher(SpectrumPublisher* publisher) {
+    analyzer_.set_publisher(publisher);
+}
+
+void EclipseVisual::set_precomputed_spectra(const SpectraFile* spectra) {
+    analyzer_.set_precomputed(spectra);
 }
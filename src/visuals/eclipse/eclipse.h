@@ -4,31 +4,35 @@
 #include <string>
 #include <vector>
 
+#include "algorithm/spectrum_analyzer.h"
 #include "algorithm/stft.h"
 #include "audio/i_source.h"
 #include "video/framebuffer.h"
 #include "video/shader_program.h"
-#include "video/vertex_buffer.h"
+#include "video/stream_buffer.h"
 #include "visuals/i_visual.h"
 
 class EclipseVisual : public IVisual {
    public:
-    EclipseVisual(const IAudioSource&, const FrameBuffer&);
+    EclipseVisual(const IAudioSource&, FrameBuffer&);
     void draw(const unsigned long) override;
 
     std::string name() override;
     void set_resolution(const float width, const float height) override;
     void set_resolution(const int width, const int height) override;
+    void set_analysis_rate(const double rate) override;
+    void set_spectrum_publisher(SpectrumPublisher* publisher) override;
+    void set_precomputed_spectra(const SpectraFile* spectra) override;
 
    private:
     const IAudioSource& audio_source_;
     const STFT stft_;
-    const FrameBuffer& fb_;
+    SpectrumAnalyzer analyzer_;
+    FrameBuffer& fb_;
 
     int num_vertices_;
-    std::vector<float> vertices_;
     ShaderProgram program_;
-    VertexBuffer vertex_buffer_;
+    StreamBuffer vertex_buffer_;
 };
 
 #endif /* ECLIPSE_H */
@@ -1,6 +1,11 @@
 R"(
 in float amplitude;
-uniform int num_freq;
+layout(std140) uniform SharedParams {
+    vec2 resolution;
+    int num_freq;
+    int min_note;
+    int max_note;
+};
 
 void main(void){
 
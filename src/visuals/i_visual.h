@@ -3,6 +3,9 @@
 
 #include <string>
 
+class SpectraFile;
+class SpectrumPublisher;
+
 class IVisual {
    public:
     virtual ~IVisual(){};
@@ -11,6 +14,15 @@ class IVisual {
     virtual std::string name() = 0;
     virtual void set_resolution(const float width, const float height) = 0;
     virtual void set_resolution(const int width, const int height) = 0;
+
+    // Analysis frames per second of audio, 0 analyses every drawn frame
+    virtual void set_analysis_rate(const double rate) = 0;
+
+    // Share every analysed spectrum with other processes, null to stop
+    virtual void set_spectrum_publisher(SpectrumPublisher* publisher) = 0;
+
+    // Draw from spectra analysed ahead of time, null to analyse live
+    virtual void set_precomputed_spectra(const SpectraFile* spectra) = 0;
 };
 
 #endif /* I_VISUAL_H */
@@ -1,9 +1,11 @@
 R"(
 precision mediump float;
-uniform int min_note;
-uniform int max_note;
-
-uniform vec2 resolution;
+layout(std140) uniform SharedParams {
+    vec2 resolution;
+    int num_freq;
+    int min_note;
+    int max_note;
+};
 out vec4 FragColor;
 
 void main(void) {
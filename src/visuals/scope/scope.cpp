@@ -0,0 +1,142 @@
+#include "scope.h"
+
+#include <algorithm>  // max, min
+#include <cmath>
+
+#include "algorithm/note_stft.h"
+
+static const char* src_shader_vertex =
+#include "visuals/scope/vertex.glsl"
+    ;
+static const char* src_shader_fragment =
+#include "visuals/scope/fragment.glsl"
+    ;
+static const char* src_shader_track_vertex =
+#include "visuals/scope/track_vertex.glsl"
+    ;
+
+// Strips of 2 vertices per column: envelope left and right, RMS left and right
+static constexpr int num_strips = 4;
+
+ScopeVisual::ScopeVisual(const IAudioSource& audio_source, FrameBuffer& fb)
+    : audio_source_(audio_source),
+      pyramid_(audio_source),
+      fb_(fb),
+      vertex_buffer_(num_strips * 2 * max_columns),
+      track_(audio_source) {
+    // Compile and link shaders
+    program_.compile(src_shader_vertex, src_shader_fragment);
+    num_columns_ = program_.uniform("num_columns");
+    track_program_.compile(src_shader_track_vertex, src_shader_fragment);
+    first_sample_ = track_program_.uniform("first_sample");
+    first_offset_ = track_program_.uniform("first_offset");
+    channel_ = track_program_.uniform("channel");
+
+    // Where the samples are in the track texture never changes
+    track_program_.set_uniform("num_samples", (int)track_.num_samples());
+    track_program_.set_uniform("row_length", track_.row_length());
+    track_program_.set_uniform("layer_size", track_.layer_size());
+
+    // Set shared parameters, the note range is kept for the background
+    SharedParams& params = fb_.shared_params();
+    params.num_freq = note_stft::num_notes;
+    params.min_note = note_stft::min_note;
+    params.max_note = note_stft::max_note;
+    program_.set_block("SharedParams", SharedParams::binding);
+    track_program_.set_block("SharedParams", SharedParams::binding);
+}
+
+void ScopeVisual::draw(const unsigned long position) {
+    // One column per pixel of the render target
+    const int num_columns = std::max(
+        1, std::min(max_columns, (int)fb_.shared_params().resolution[0]));
+    const double span = span_ * audio_source_.sample_rate();
+    const double start = position - 0.5 * span;
+
+    if (span <= max_line_samples * num_columns) {
+        draw_samples(start, span);
+    } else {
+        draw_envelope(start, span, num_columns);
+    }
+}
+
+void ScopeVisual::draw_envelope(const double start, const double span,
+                                int num_columns) {
+    const double samples_per_column = span / num_columns;
+
+    // Write straight into this frame's region of the vertex buffer, only the
+    // strips of this many columns are drawn
+    float* vertices = vertex_buffer_.map();
+    const int strip_size = 2 * num_columns;
+    for (int column = 0; column < num_columns; column++) {
+        const long first =
+            (long)std::floor(start + column * samples_per_column);
+        const long last =
+            (long)std::floor(start + (column + 1) * samples_per_column);
+        for (unsigned long ch = 0; ch < 2; ch++) {
+            const WaveformPyramid::Range range = pyramid_.range(
+                std::min(ch, audio_source_.num_channels() - 1), first, last);
+            float* envelope = vertices + ch * strip_size + 2 * column;
+            float* rms = vertices + (2 + ch) * strip_size + 2 * column;
+            envelope[0] = range.min;
+            envelope[1] = range.max;
+            rms[0] = -range.rms;
+            rms[1] = range.rms;
+        }
+    }
+
+    // Update the data
+    vertex_buffer_.unmap();
+    program_.set_input("amplitude", vertex_buffer_);
+    program_.set_uniform(num_columns_, num_columns);
+
+    // Draw
+    fb_.bind();
+    program_.use();
+    for (int strip = 0; strip < num_strips; strip++)
+        glDrawArrays(GL_TRIANGLE_STRIP, strip * strip_size, strip_size);
+    fb_.unbind();
+}
+
+void ScopeVisual::draw_samples(const double start, const double span) {
+    // Every sample from just left of the edge to just right of it
+    const long first = (long)std::floor(start);
+    const int num_points = (int)(std::ceil(start + span) - first) + 1;
+    track_program_.set_uniform(first_sample_, (int)first);
+    track_program_.set_uniform(first_offset_, (float)(first - start));
+    track_program_.set_uniform("span", (float)span);
+
+    // Draw
+    fb_.bind();
+    track_program_.use();
+    track_.bind();
+    for (int ch = 0; ch < 2; ch++) {
+        track_program_.set_uniform(channel_, ch);
+        glDrawArrays(GL_LINE_STRIP, 0, num_points);
+    }
+    fb_.unbind();
+}
+
+std::string ScopeVisual::name() { return std::string("Scope"); }
+
+void ScopeVisual::set_resolution(const float width, const float height) {
+    fb_.shared_params().resolution[0] = width;
+    fb_.shared_params().resolution[1] = height;
+}
+
+void ScopeVisual::set_resolution(const int width, const int height) {
+    set_resolution((float)width, (float)height);
+}
+
+void ScopeVisual::set_span(const double seconds) {
+    const double length =
+        (double)audio_source_.num_samples() / audio_source_.sample_rate();
+    span_ = std::max(1e-3, std::min(seconds, std::max(length, 1e-3)));
+}
+
+// The scope draws the waveform itself, there are no spectra to analyse
+void ScopeVisual::set_analysis_rate(const double) {}
+
+void ScopeVisual::set_spectrum_publisher(SpectrumPublisher*) {}
+
+void ScopeVisual::set_precomputed_spectra(const SpectraFile*) {}
@@ -0,0 +1,60 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <string>
+
+#include "algorithm/waveform_pyramid.h"
+#include "audio/i_source.h"
+#include "video/framebuffer.h"
+#include "video/shader_program.h"
+#include "video/stream_buffer.h"
+#include "video/track_buffer.h"
+#include "visuals/i_visual.h"
+
+// Oscilloscope of both channels around the playback position, one column of
+// min/max envelope and RMS band per pixel. Columns come from the waveform
+// pyramid, so drawing costs the same at any zoom. Zoomed in to a few samples
+// per pixel, the samples themselves are drawn as lines from the track on the
+// GPU instead, with nothing uploaded per frame.
+class ScopeVisual : public IVisual {
+   public:
+    ScopeVisual(const IAudioSource&, FrameBuffer&);
+    void draw(const unsigned long) override;
+
+    std::string name() override;
+    void set_resolution(const float width, const float height) override;
+    void set_resolution(const int width, const int height) override;
+    void set_analysis_rate(const double rate) override;
+    void set_spectrum_publisher(SpectrumPublisher* publisher) override;
+    void set_precomputed_spectra(const SpectraFile* spectra) override;
+
+    // Seconds of audio across the width, centred on the position
+    void set_span(const double seconds);
+
+   private:
+    static constexpr int max_columns = 4096;
+
+    // Draw lines through the samples up to this many samples per column
+    static constexpr double max_line_samples = 2;
+
+    const IAudioSource& audio_source_;
+    const WaveformPyramid pyramid_;
+    FrameBuffer& fb_;
+    double span_ = 0.05;
+
+    ShaderProgram program_;
+    UniformHandle num_columns_;
+    StreamBuffer vertex_buffer_;
+
+    const TrackBuffer track_;
+    ShaderProgram track_program_;
+    UniformHandle first_sample_;
+    UniformHandle first_offset_;
+    UniformHandle channel_;
+
+    // Start is the sample at the left edge, span the samples across
+    void draw_envelope(const double start, const double span, int columns);
+    void draw_samples(const double start, const double span);
+};
+
+#endif /* SCOPE_H */
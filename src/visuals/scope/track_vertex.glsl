@@ -0,0 +1,42 @@
+R"(
+uniform sampler2DArray track;
+uniform int first_sample;    // Sample drawn by the first vertex
+uniform float first_offset;  // Its distance from the left edge in samples
+uniform float span;          // Samples across the width
+uniform int num_samples;
+uniform int row_length;
+uniform int layer_size;
+uniform int channel;
+layout(std140) uniform SharedParams {
+    vec2 resolution;
+    int num_freq;
+    int min_note;
+    int max_note;
+};
+out vec3 color;
+
+void main(void){
+
+    // One vertex per sample, read straight from the track texture
+    int index = first_sample + gl_VertexID;
+    float amplitude = 0.0;
+    if (index >= 0 && index < num_samples) {
+        int layer = index / layer_size;
+        int offset = index % layer_size;
+        ivec3 texel = ivec3(offset % row_length, offset / row_length, layer);
+        vec2 value = texelFetch(track, texel, 0).rg;
+        amplitude = channel == 0 ? value.r : value.g;
+    }
+
+    // Normalize time to [-1,1]
+    float x_pos = 2.0 * (first_offset + float(gl_VertexID)) / span - 1.0;
+
+    // Left channel in the upper half, right in the lower
+    float center = channel == 0 ? 0.5 : -0.5;
+    float y_pos = center + 0.45 * amplitude;
+
+    color = vec3(0.55, 0.75, 0.95);
+
+    gl_Position = vec4( x_pos, y_pos, 0.0, 1.0);
+
+})"
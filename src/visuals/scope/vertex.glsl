@@ -0,0 +1,39 @@
+R"(
+in float amplitude;
+uniform int num_columns;
+layout(std140) uniform SharedParams {
+    vec2 resolution;
+    int num_freq;
+    int min_note;
+    int max_note;
+};
+out vec3 color;
+
+void main(void){
+
+    // Four triangle strips of two vertices per column: the min/max envelope
+    // of the left and right channel, then their RMS bands
+    int strip = gl_VertexID / (2*num_columns);
+    int vertexID = gl_VertexID % (2*num_columns);
+    int channel = strip % 2;
+    bool top = vertexID % 2 == 1;
+
+    // Column centre normalized to [-1,1]
+    float column = floor(float(vertexID)/2.0);
+    float x_pos = 2.0 * (column + 0.5) / float(num_columns) - 1.0;
+
+    // Left channel in the upper half, right in the lower, and at least a
+    // pixel thick so silence still shows as a line
+    float center = channel == 0 ? 0.5 : -0.5;
+    float pixel = top ? 1.0 / resolution.y : -1.0 / resolution.y;
+    float y_pos = center + 0.45 * amplitude + pixel;
+
+    if (strip < 2) {
+        color = vec3(0.10, 0.30, 0.55);
+    } else {
+        color = vec3(0.55, 0.75, 0.95);
+    }
+
+    gl_Position = vec4( x_pos, y_pos, 0.0, 1.0);
+
+})"
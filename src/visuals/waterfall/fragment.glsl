@@ -0,0 +1,56 @@
+R"(
+precision mediump float;
+uniform sampler2D history;
+uniform float newest;  // Texture row of the newest spectrum
+uniform int num_rows;
+layout(std140) uniform SharedParams {
+    vec2 resolution;
+    int num_freq;
+    int min_note;
+    int max_note;
+};
+out vec4 FragColor;
+
+const vec3 note_colors[12] = vec3[12](
+    vec3(1.0, 0.0, 0.0),
+    vec3(1.0, 0.53272112, 0.0),
+    vec3(0.93455776, 1.0, 0.0),
+    vec3(0.40183664, 1.0, 0.0),
+    vec3(0.0, 1.0, 0.15404569),
+    vec3(0.0, 1.0, 0.68676346),
+    vec3(0.0, 0.78051739, 1.0),
+    vec3(0.0, 0.24779627, 1.0),
+    vec3(0.30808664, 0.0, 1.0),
+    vec3(0.84080776, 0.0, 1.0),
+    vec3(1.0, 0.0, 0.62647112),
+    vec3(1.0, 0.0, 0.09375000));
+
+void main(void) {
+
+    // Coordinates in normalized space
+    float xpos = 2.0 * gl_FragCoord.x / resolution.x - 1.0;
+    float ypos = gl_FragCoord.y / resolution.y;
+
+    // Left channel on the left, right on the right, low notes in the middle
+    float freq_idx = abs(xpos);
+
+    // Newest spectrum at the top, older ones further down. The history
+    // wraps around the texture, which repeats vertically.
+    float age = (1.0 - ypos) * float(num_rows - 1);
+    float column = freq_idx * float(num_freq - 1) + 0.5;
+    vec2 coord = vec2(column / float(num_freq),
+                      (newest + 0.5 - age) / float(num_rows));
+    vec2 power = texture(history, coord).rg;
+    float amplitude = xpos < 0.0 ? power.r : power.g;
+
+    // Colour of the nearest note, brighter the louder. Peaks are orders of
+    // magnitude above the rest, so the brightness follows their logarithm.
+    float range = max_note - min_note;
+    float note_idx = freq_idx * range - range / 2.0;
+    int nearest = int(round(mod(note_idx, 12.0))) % 12;
+    float intensity = clamp(0.25 * log2(1.0 + 4.0 * amplitude), 0.0, 1.0);
+
+    FragColor = vec4(note_colors[nearest] * intensity, 1.0);
+
+}
+)"
@@ -0,0 +1,10 @@
+R"(
+void main(void){
+
+    // Full screen quad as a triangle strip, no vertex data needed
+    float x_pos = gl_VertexID % 2 == 0 ? -1.0 : 1.0;
+    float y_pos = gl_VertexID < 2 ? -1.0 : 1.0;
+
+    gl_Position = vec4( x_pos, y_pos, 0.0, 1.0);
+
+})"
@@ -0,0 +1,118 @@
+#include "waterfall.h"
+
+#include <algorithm>  // max
+#include <vector>
+
+#include "algorithm/note_stft.h"
+#include "video/gl_state.h"
+
+static const char* src_shader_vertex =
+#include "visuals/waterfall/vertex.glsl"
+    ;
+static const char* src_shader_fragment =
+#include "visuals/waterfall/fragment.glsl"
+    ;
+
+static constexpr int default_history = 512;
+
+WaterfallVisual::WaterfallVisual(const IAudioSource& audio_source,
+                                 FrameBuffer& fb)
+    : audio_source_(audio_source),
+      stft_(create_note_stft(audio_source.sample_rate())),
+      analyzer_(audio_source, stft_),
+      fb_(fb),
+      row_(2 * stft_.length()) {
+    // Compile and link shader
+    program_.compile(src_shader_vertex, src_shader_fragment);
+    newest_ = program_.uniform("newest");
+
+    // Set shared parameters and array
+    SharedParams& params = fb_.shared_params();
+    params.num_freq = (int)stft_.length();
+    params.min_note = note_stft::min_note;
+    params.max_note = note_stft::max_note;
+    program_.set_block("SharedParams", SharedParams::binding);
+
+    set_history(default_history);
+}
+
+WaterfallVisual::~WaterfallVisual() {
+    gl_state::forget_texture(texture_);
+    glDeleteTextures(1, &texture_);
+}
+
+void WaterfallVisual::set_history(const int rows) {
+    if (texture_) {
+        gl_state::forget_texture(texture_);
+        glDeleteTextures(1, &texture_);
+    }
+    num_rows_ = std::max(2, rows);
+    newest_row_ = -1;
+    drawn_position_ = -1;
+
+    // Rows wrap vertically, so sampling across the ring seam needs no care
+    const std::vector<float> zeros(row_.size() * num_rows_, 0.0f);
+    glGenTextures(1, &texture_);
+    gl_state::bind_texture(GL_TEXTURE_2D, texture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32F, stft_.length(), num_rows_);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stft_.length(), num_rows_, GL_RG,
+                    GL_FLOAT, zeros.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    gl_state::bind_texture(GL_TEXTURE_2D, 0);
+
+    program_.set_uniform("num_rows", num_rows_);
+}
+
+void WaterfallVisual::draw(const unsigned long position) {
+    // Only a new position adds a row, redrawing the same one must not scroll
+    if ((long)position != drawn_position_) {
+        drawn_position_ = position;
+        analyzer_.update(position);
+        const std::vector<float>& power_left = analyzer_.left();
+        const std::vector<float>& power_right = analyzer_.right();
+        for (unsigned long idx = 0; idx < stft_.length(); idx++) {
+            row_[2 * idx] = power_left[idx];
+            row_[2 * idx + 1] = power_right[idx];
+        }
+
+        // Overwrite the oldest row, the rest of the history stays put
+        newest_row_ = (newest_row_ + 1) % num_rows_;
+        gl_state::bind_texture(GL_TEXTURE_2D, texture_);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, newest_row_, stft_.length(), 1,
+                        GL_RG, GL_FLOAT, row_.data());
+        program_.set_uniform(newest_, (float)newest_row_);
+    }
+
+    // Draw
+    fb_.bind();
+    program_.use();
+    gl_state::bind_texture(GL_TEXTURE_2D, texture_);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    fb_.unbind();
+}
+
+std::string WaterfallVisual::name() { return std::string("Waterfall"); }
+
+void WaterfallVisual::set_resolution(const float width, const float height) {
+    fb_.shared_params().resolution[0] = width;
+    fb_.shared_params().resolution[1] = height;
+}
+
+void WaterfallVisual::set_resolution(const int width, const int height) {
+    set_resolution((float)width, (float)height);
+}
+
+void WaterfallVisual::set_analysis_rate(const double rate) {
+    analyzer_.set_rate(rate);
+}
+
+void WaterfallVisual::set_spectrum_publisher(SpectrumPublisher* publisher) {
+    analyzer_.set_publisher(publisher);
+}
+
+void WaterfallVisual::set_precomputed_spectra(const SpectraFile* spectra) {
+    analyzer_.set_precomputed(spectra);
+}
@@ -0,0 +1,52 @@
+#ifndef WATERFALL_H
+#define WATERFALL_H
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include "algorithm/spectrum_analyzer.h"
+#include "algorithm/stft.h"
+#include "audio/i_source.h"
+#include "video/framebuffer.h"
+#include "video/shader_program.h"
+#include "visuals/i_visual.h"
+
+// Scrolling spectrogram of both channels, newest at the top. The history is
+// a ring of rows in a texture: each new position writes one row over the
+// oldest and the shader offsets its lookups to match, so a frame costs the
+// same however many rows are shown.
+class WaterfallVisual : public IVisual {
+   public:
+    WaterfallVisual(const IAudioSource&, FrameBuffer&);
+    ~WaterfallVisual();
+    void draw(const unsigned long) override;
+
+    std::string name() override;
+    void set_resolution(const float width, const float height) override;
+    void set_resolution(const int width, const int height) override;
+    void set_analysis_rate(const double rate) override;
+    void set_spectrum_publisher(SpectrumPublisher* publisher) override;
+    void set_precomputed_spectra(const SpectraFile* spectra) override;
+
+    // Spectra kept on screen, one per drawn position. Clears the history.
+    void set_history(const int rows);
+
+   private:
+    const IAudioSource& audio_source_;
+    const STFT stft_;
+    SpectrumAnalyzer analyzer_;
+    FrameBuffer& fb_;
+
+    ShaderProgram program_;
+    UniformHandle newest_;
+
+    GLuint texture_ = 0;
+    int num_rows_ = 0;
+    int newest_row_ = -1;
+    long drawn_position_ = -1;
+    std::vector<float> row_;  // Left and right interleaved, as uploaded
+};
+
+#endif /* WATERFALL_H */